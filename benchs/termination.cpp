@@ -0,0 +1,193 @@
+
+// microbenchmark for sched::termination_barrier: measures the cost of the
+// active/inactive transitions under contention and the time the threads take
+// to notice termination, from 1 to 64 threads, against a single global counter
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+#include <time.h>
+#include <sched.h>
+#include <boost/thread/thread.hpp>
+
+#include "sched/thread/termination_barrier.hpp"
+#include "utils/atomic.hpp"
+
+using namespace std;
+
+#define TRANSITIONS 200000
+#define TRIALS 200
+#define MAX_THREADS 64
+#define IDLE_WORK 32
+
+// the previous barrier, with one counter for all the threads
+class flat_barrier
+{
+private:
+
+   utils::atomic<size_t> active_threads;
+   volatile bool done;
+
+public:
+
+   inline void reset(void) { done = false; }
+   inline void is_active(const size_t) { active_threads++; }
+   inline void is_inactive(const size_t)
+   {
+      if(--active_threads == 0)
+         done = true;
+   }
+   inline bool all_finished(void) const { return done; }
+
+   explicit flat_barrier(const size_t num_threads):
+      active_threads(num_threads), done(false)
+   {
+   }
+};
+
+static inline uint64_t
+now_ns(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * (uint64_t)1000000000 + ts.tv_nsec;
+}
+
+// sense reversing barrier to start each trial at the same time
+class start_barrier
+{
+private:
+
+   utils::atomic<size_t> count;
+   const size_t total;
+   volatile bool sense;
+
+public:
+
+   void wait(bool& my_sense)
+   {
+      my_sense = !my_sense;
+      if(--count == 0) {
+         count = total;
+         sense = my_sense;
+      } else {
+         while(sense != my_sense)
+            sched_yield();
+      }
+   }
+
+   explicit start_barrier(const size_t n): count(n), total(n), sense(false) {}
+};
+
+template <class BARRIER>
+struct bench_run
+{
+   BARRIER barrier;
+   start_barrier start;
+   const size_t num_threads;
+   vector<uint64_t> inactive_time;
+   vector<uint64_t> seen_time;
+   vector<uint64_t> latencies;
+
+   void contention(const size_t id)
+   {
+      volatile size_t work(0);
+
+      for(size_t i(0); i < TRANSITIONS; ++i) {
+         barrier.is_inactive(id);
+         for(size_t j(0); j < IDLE_WORK; ++j)
+            work++;
+         barrier.is_active(id);
+      }
+   }
+
+   void latency(const size_t id)
+   {
+      bool sense(false);
+
+      for(size_t t(0); t < TRIALS; ++t) {
+         start.wait(sense);
+
+         inactive_time[id] = now_ns();
+         barrier.is_inactive(id);
+         while(!barrier.all_finished())
+            sched_yield();
+         seen_time[id] = now_ns();
+
+         start.wait(sense);
+
+         if(id == 0) {
+            uint64_t last_inactive(0), last_seen(0);
+            for(size_t i(0); i < num_threads; ++i) {
+               last_inactive = max(last_inactive, inactive_time[i]);
+               last_seen = max(last_seen, seen_time[i]);
+            }
+            latencies.push_back(last_seen - last_inactive);
+            barrier.reset();
+         }
+         barrier.is_active(id);
+      }
+   }
+
+   uint64_t run(void (bench_run::*fun)(const size_t))
+   {
+      vector<boost::thread*> threads;
+      const uint64_t before(now_ns());
+
+      for(size_t i(0); i < num_threads; ++i)
+         threads.push_back(new boost::thread(fun, this, i));
+      for(size_t i(0); i < num_threads; ++i) {
+         threads[i]->join();
+         delete threads[i];
+      }
+
+      return now_ns() - before;
+   }
+
+   explicit bench_run(const size_t n):
+      barrier(n), start(n), num_threads(n),
+      inactive_time(n, 0), seen_time(n, 0)
+   {
+   }
+};
+
+template <class BARRIER>
+static void
+measure(const size_t num_threads, double& transition_ns, double& latency_us)
+{
+   {
+      bench_run<BARRIER> b(num_threads);
+      const uint64_t total(b.run(&bench_run<BARRIER>::contention));
+      transition_ns = (double)total / (double)TRANSITIONS;
+   }
+   {
+      bench_run<BARRIER> b(num_threads);
+      b.run(&bench_run<BARRIER>::latency);
+      uint64_t sum(0);
+      for(size_t i(0); i < b.latencies.size(); ++i)
+         sum += b.latencies[i];
+      latency_us = (double)sum / (double)b.latencies.size() / 1000.0;
+   }
+}
+
+int
+main(int argc, char **argv)
+{
+   const size_t max_threads(argc > 1 ? (size_t)atoi(argv[1]) : MAX_THREADS);
+
+   cout << "threads\tflat ns/transition\ttree ns/transition\tflat latency us\ttree latency us" << endl;
+   cout << fixed << setprecision(2);
+
+   for(size_t n(1); n <= max_threads; n *= 2) {
+      double flat_trans, flat_lat, tree_trans, tree_lat;
+
+      measure<flat_barrier>(n, flat_trans, flat_lat);
+      measure<sched::termination_barrier>(n, tree_trans, tree_lat);
+
+      cout << n << "\t" << flat_trans << "\t\t\t" << tree_trans << "\t\t\t"
+         << flat_lat << "\t\t" << tree_lat << endl;
+   }
+
+   return EXIT_SUCCESS;
+}
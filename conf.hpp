@@ -22,6 +22,12 @@
 // activate instrumentation code
 // #define INSTRUMENTATION 1
 
+// measure how long nodes wait to run after getting new facts (printed with -l)
+// #define NODE_LATENCY_STATISTICS 1
+
+// count the most frequent opcode pairs and triples (see vm/stat.hpp)
+// #define OPCODE_PROFILING 1
+
 // use simulator
 //#define USE_SIM
 
@@ -42,5 +48,11 @@ const bool USE_ALLOCATOR = true;
 // activate dynamic indexing of linear facts
 #define DYNAMIC_INDEXING 1
 
+// pack tuple fields by size instead of using a full tuple_field for each one
+#define COMPACT_TUPLES 1
+
+// keep a bloom filter of the first argument of persistent facts to skip searches that must fail
+#define TRIE_FILTERS 1
+
 #endif
 
@@ -1,3 +1,4 @@
 RELEASE = true
 INTERFACE = false
 JIT = false
+NUMA = false
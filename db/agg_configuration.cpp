@@ -8,6 +8,105 @@ using namespace runtime;
 namespace db
 {
 
+bool agg_configuration::INCREMENTAL(true);
+
+void
+agg_configuration::setup_incremental(vm::predicate *pred)
+{
+   assert(vals.empty());
+
+   sum_int = 0;
+   ints.clear();
+   floats.clear();
+   incremental = false;
+
+   if(!INCREMENTAL || pred->is_cycle_pred())
+      return;
+
+   // float sums are always recomputed from all the values, since a running
+   // total rounds differently than adding the values in the order of the trie
+   switch(pred->get_aggregate_type()) {
+      case AGG_SUM_INT:
+      case AGG_MAX_INT:
+      case AGG_MIN_INT:
+      case AGG_MAX_FLOAT:
+      case AGG_MIN_FLOAT:
+         incremental = true;
+         break;
+      default:
+         break;
+   }
+}
+
+void
+agg_configuration::update_incremental(vm::tuple *tpl, vm::predicate *pred, const derivation_count many)
+{
+   const field_num field(pred->get_aggregate_field());
+
+   switch(pred->get_aggregate_type()) {
+      case AGG_SUM_INT:
+         sum_int += tpl->get_int(field) * (int_val)many;
+         break;
+      default:
+         break;
+   }
+}
+
+void
+agg_configuration::add_extreme(vm::tuple *tpl, vm::predicate *pred)
+{
+   const field_num field(pred->get_aggregate_field());
+
+   switch(pred->get_aggregate_type()) {
+      case AGG_MAX_INT:
+      case AGG_MIN_INT:
+         ints.insert(make_pair(tpl->get_int(field), tpl));
+         break;
+      case AGG_MAX_FLOAT:
+      case AGG_MIN_FLOAT:
+         floats.insert(make_pair(tpl->get_float(field), tpl));
+         break;
+      default:
+         break;
+   }
+}
+
+void
+agg_configuration::remove_extreme(vm::tuple *tpl, vm::predicate *pred)
+{
+   const field_num field(pred->get_aggregate_field());
+
+   // tpl is a copy of the stored tuple, so find the entry by its contents
+   switch(pred->get_aggregate_type()) {
+      case AGG_MAX_INT:
+      case AGG_MIN_INT: {
+         pair<int_extremes::iterator, int_extremes::iterator> range(ints.equal_range(tpl->get_int(field)));
+         for(int_extremes::iterator it(range.first); it != range.second; ++it) {
+            if(it->second->equal(*tpl, pred)) {
+               ints.erase(it);
+               return;
+            }
+         }
+         assert(false);
+      }
+      break;
+      case AGG_MAX_FLOAT:
+      case AGG_MIN_FLOAT: {
+         pair<float_extremes::iterator, float_extremes::iterator> range(floats.equal_range(tpl->get_float(field)));
+         for(float_extremes::iterator it(range.first); it != range.second; ++it) {
+            if(it->second->equal(*tpl, pred)) {
+               floats.erase(it);
+               return;
+            }
+         }
+         assert(false);
+      }
+      break;
+      default:
+         break;
+   }
+}
+
 void
 agg_configuration::add_to_set(vm::tuple *tpl, vm::predicate *pred, const derivation_count many, const depth_t depth)
 {
@@ -19,13 +118,19 @@ agg_configuration::add_to_set(vm::tuple *tpl, vm::predicate *pred, const derivat
 #ifndef NDEBUG
    const size_t start_size(vals.size());
 #endif
+
+   if(vals.empty())
+      setup_incremental(pred);
    
    if(many > 0) {
+      if(incremental)
+         update_incremental(tpl, pred, many);
       
       if(!vals.insert_tuple(tpl, pred, many, depth)) {
          // repeated tuple
          vm::tuple::destroy(tpl, pred);
-      }
+      } else if(incremental)
+         add_extreme(tpl, pred);
 
       assert(vals.size() == start_size + many);
    } else {
@@ -34,7 +139,13 @@ agg_configuration::add_to_set(vm::tuple *tpl, vm::predicate *pred, const derivat
       if(!deleter.is_valid()) {
          changed = false;
       } else if(deleter.to_delete()) {
+         if(incremental) {
+            update_incremental(tpl, pred, many);
+            remove_extreme(tpl, pred);
+         }
          deleter.perform_delete(pred);
+      } else if(incremental) {
+         update_incremental(tpl, pred, many);
       } else if(pred->is_cycle_pred()) {
          depth_counter *dc(deleter.get_depth_counter());
          assert(dc != NULL);
@@ -327,12 +438,48 @@ agg_configuration::generate_sum_list_float(predicate *pred, const field_num fiel
    return ret;
 }
 
+vm::tuple*
+agg_configuration::generate_incremental(predicate *pred, const aggregate_type typ, const field_num field) const
+{
+   assert(!vals.empty());
+
+   switch(typ) {
+      case AGG_SUM_INT: {
+         vm::tuple *ret((*vals.begin())->get_underlying_tuple()->copy(pred));
+         ret->set_int(field, sum_int);
+         return ret;
+      }
+      case AGG_MAX_INT:
+         assert(!ints.empty());
+         // first of the tuples with the maximum value, like the full scan
+         return ints.lower_bound(ints.rbegin()->first)->second->copy(pred);
+      case AGG_MIN_INT:
+         assert(!ints.empty());
+         return ints.begin()->second->copy(pred);
+      case AGG_MAX_FLOAT:
+         assert(!floats.empty());
+         // first of the tuples with the maximum value, like the full scan
+         return floats.lower_bound(floats.rbegin()->first)->second->copy(pred);
+      case AGG_MIN_FLOAT:
+         assert(!floats.empty());
+         return floats.begin()->second->copy(pred);
+      default:
+         break;
+   }
+
+   assert(false);
+   return NULL;
+}
+
 vm::tuple*
 agg_configuration::do_generate(predicate *pred, const aggregate_type typ, const field_num field, vm::depth_t& depth)
 {
    if(vals.empty())
       return NULL;
 
+   if(incremental)
+      return generate_incremental(pred, typ, field);
+
    switch(typ) {
       case AGG_FIRST:
          return generate_first(pred, depth);
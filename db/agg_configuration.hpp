@@ -3,6 +3,7 @@
 #define DB_AGG_CONFIGURATION_HPP
 
 #include <ostream>
+#include <map>
 
 #include "mem/base.hpp"
 #include "db/tuple.hpp"
@@ -23,6 +24,24 @@ private:
    bool changed;
    vm::tuple *corresponds;
    vm::depth_t last_depth;
+
+   // incremental state for integer sums, minimums and maximums:
+   // sums are updated on every insert and delete and minimums/maximums
+   // keep the values of the aggregate field ordered, one per trie leaf.
+   // the other aggregates (float sums, which must round like the scan, and
+   // cycle predicates, which need the depths of the values) still scan vals
+   bool incremental;
+   vm::int_val sum_int;
+   typedef std::multimap<vm::int_val, vm::tuple*> int_extremes;
+   typedef std::multimap<vm::float_val, vm::tuple*> float_extremes;
+   int_extremes ints;
+   float_extremes floats;
+
+   void setup_incremental(vm::predicate *);
+   void update_incremental(vm::tuple *, vm::predicate *, const vm::derivation_count);
+   void add_extreme(vm::tuple *, vm::predicate *);
+   void remove_extreme(vm::tuple *, vm::predicate *);
+   vm::tuple *generate_incremental(vm::predicate *, const vm::aggregate_type, const vm::field_num) const;
    
    vm::tuple *generate_max_int(vm::predicate *, const vm::field_num, vm::depth_t&) const;
    vm::tuple *generate_min_int(vm::predicate *, const vm::field_num, vm::depth_t&) const;
@@ -43,6 +62,10 @@ public:
 
    MEM_METHODS(agg_configuration)
 
+   // when false, every aggregate is recomputed from all the values
+   // (used to validate the incremental aggregates)
+   static bool INCREMENTAL;
+
    void print(std::ostream&, vm::predicate *) const;
 
    void generate(vm::predicate *, const vm::aggregate_type, const vm::field_num, simple_tuple_list&);
@@ -58,13 +81,16 @@ public:
    bool matches_first_int_arg(vm::predicate *, const vm::int_val) const;
 
    explicit agg_configuration(void):
-      changed(false), corresponds(NULL), last_depth(0)
+      changed(false), corresponds(NULL), last_depth(0),
+      incremental(false), sum_int(0)
    {
       assert(corresponds == NULL);
       assert(!changed);
    }
 
    inline void wipeout(vm::predicate *pred) {
+      ints.clear();
+      floats.clear();
       vals.wipeout(pred);
    }
 };
@@ -1,8 +1,14 @@
 
+#include <algorithm>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
 #include "vm/defs.hpp"
 #include "db/database.hpp"
 #include "process/router.hpp"
 #include "vm/state.hpp"
+#include "utils/numa.hpp"
+#include "vm/reader.hpp"
 
 using namespace db;
 using namespace std;
@@ -13,21 +19,59 @@ using namespace utils;
 namespace db
 {
    
+// the node table is split among several loaders, each one allocating
+// nodes from its own pool (in NUMA mode, a pool on the socket it loads for)
+static const size_t MIN_NODES_PER_LOADER(4096);
+
+static inline int
+node_socket(const node::node_id id)
+{
+   // with fewer nodes than threads, the last thread owns every node
+   const process_id owner(remote::self->get_nodes_per_proc() == 0 ?
+         remote::self->get_num_threads() - 1 : remote::self->find_proc_owner(id));
+   return numa_thread_socket(owner);
+}
+
+static void
+load_nodes(database::create_node_fn create_fn, const byte *table,
+      const size_t start, const size_t end, node **out, const int socket)
+{
+   for(size_t i(start); i < end; ++i) {
+      node::node_id ids[2];
+
+      memcpy(ids, table + i * database::node_size, database::node_size);
+
+      if(socket >= 0 && node_socket(ids[0]) != socket)
+         continue;
+
+      out[i] = create_fn(ids[0], ids[1]);
+   }
+}
+
+// the pool of a loader thread holds the nodes it created, so it is
+// released when the loader is done and taken over by a worker thread
+// (of the same socket in NUMA mode)
+static void
+load_nodes_thread(database::create_node_fn create_fn, const byte *table,
+      const size_t start, const size_t end, node **out, const int socket)
+{
+   mem::ensure_pool(socket);
+   load_nodes(create_fn, table, start, end, out, socket);
+   mem::release_pool();
+}
+   
 database::database(const string& filename, create_node_fn _create_fn):
    create_fn(_create_fn), nodes_total(0)
 {
    int_val num_nodes;
-   node::node_id fake_id;
-   node::node_id real_id;
-   
-   ifstream fp(filename.c_str(), ios::in | ios::binary);
+   code_reader read(filename);
 
-   fp.seekg(vm::MAGIC_SIZE, ios_base::cur); // skip magic
-   fp.seekg(2*sizeof(uint32_t), ios_base::cur); // skip version
+   read.seek(vm::MAGIC_SIZE); // skip magic
+   read.seek(2*sizeof(uint32_t)); // skip version
    
-   fp.seekg(sizeof(byte), ios_base::cur); // skip number of definitions
+   read.seek(sizeof(byte)); // skip number of definitions
    
-   fp.read((char*)&num_nodes, sizeof(int_val));
+   read.read_type<int_val>(&num_nodes);
    
    nodes_total = num_nodes;
    
@@ -36,21 +80,59 @@ database::database(const string& filename, create_node_fn _create_fn):
    const size_t nodes_to_skip(remote::self->get_nodes_base());
    
    if(nodes_to_skip > 0)
-      fp.seekg(node_size * nodes_to_skip, ios_base::cur);
+      read.seek(node_size * nodes_to_skip);
    
-   size_t nodes_to_read = remote::self->get_total_nodes();
+   const size_t nodes_to_read(remote::self->get_total_nodes());
+   const byte *table(read.read_in_place(node_size * nodes_to_read));
+   vector<node*> created(nodes_to_read, NULL);
+   vector<int> sockets;
+
+   if(numa_enabled()) {
+      // one loader per socket
+      for(size_t i(0); i < All->NUM_THREADS; ++i) {
+         const int socket(numa_thread_socket(i));
+         if(find(sockets.begin(), sockets.end(), socket) == sockets.end())
+            sockets.push_back(socket);
+      }
+   }
+
+   const size_t num_loaders(numa_enabled() ? sockets.size() :
+         max((size_t)1, min(All->NUM_THREADS, nodes_to_read / MIN_NODES_PER_LOADER)));
+   vector<boost::thread*> loaders;
 
-   max_node_id = 0;
-   max_translated_id = 0;
+   for(size_t i(1); i < num_loaders; ++i) {
+      if(numa_enabled())
+         loaders.push_back(new boost::thread(boost::bind(load_nodes_thread, create_fn, table,
+                     0, nodes_to_read, &created[0], sockets[i])));
+      else
+         loaders.push_back(new boost::thread(boost::bind(load_nodes_thread, create_fn, table,
+                     (i * nodes_to_read) / num_loaders, ((i + 1) * nodes_to_read) / num_loaders,
+                     &created[0], -1)));
+   }
+
+   // the main thread loads the first part, it runs thread 0 later, which
+   // is on the first socket
+   if(numa_enabled()) {
+      mem::get_pool()->set_socket(sockets[0]);
+      load_nodes(create_fn, table, 0, nodes_to_read, &created[0], sockets[0]);
+   } else
+      load_nodes(create_fn, table, 0, nodes_to_read / num_loaders, &created[0], -1);
+
+   for(size_t i(0); i < loaders.size(); ++i) {
+      loaders[i]->join();
+      delete loaders[i];
+   }
+
+   node::node_id max_node_id(0);
+   node::node_id max_translated_id(0);
       
    for(size_t i(0); i < nodes_to_read; ++i) {
-      fp.read((char*)&fake_id, sizeof(node::node_id));
-      fp.read((char*)&real_id, sizeof(node::node_id));
+      node *n(created[i]);
+      assert(n != NULL);
+      const node::node_id fake_id(n->get_id());
+      const node::node_id real_id(n->get_translated_id());
       
-      node *node(create_fn(fake_id, real_id));
-      
-      translation[fake_id] = real_id;
-      nodes[fake_id] = node;
+      nodes.set(fake_id, n);
 
       if(fake_id > max_node_id)
          max_node_id = fake_id;
@@ -59,52 +141,47 @@ database::database(const string& filename, create_node_fn _create_fn):
    }
    
    original_max_node_id = max_node_id;
-   
-   if(!remote::i_am_last_one()) {
-      const size_t nodes_left(nodes_total - (nodes_to_skip + nodes_to_read));
-      
-      if(nodes_left > 0)
-         fp.seekg(node_size * nodes_left, ios_base::cur);
-      //remote::rout(cout) << "skip last " << nodes_left << " nodes" << endl;
-   }
+   next_node_id = nodes.empty() ? 0 : max_node_id + 1;
+   translated_offset = max_translated_id - max_node_id;
 }
 
 database::~database(void)
 {
-   for(map_nodes::iterator it(nodes.begin()); it != nodes.end(); ++it)
-      delete it->second;
+   for(iterator it(nodes.begin()), end(nodes.end()); it != end; ++it)
+      delete *it;
 }
 
 node*
 database::find_node(const node::node_id id) const
 {
-   map_nodes::const_iterator it(nodes.find(id));
+   node *ret(nodes.get(id));
 
-   if(it == nodes.end()) {
+   if(ret == NULL) {
       cerr << "Could not find node with id " << id << endl;
       abort();
    }
    
-   return it->second;
+   return ret;
 }
 
 node*
 database::create_node_id(const db::node::node_id id)
 {
-   utils::spinlock::scoped_lock l(mtx);
-   if(max_node_id > 0) {
-      assert(max_node_id < id);
-      assert(max_translated_id < id);
-   }
+   // next_node_id only moves forward, even if other threads are creating
+   // nodes with smaller ids at the same time
+   node::node_id old(next_node_id);
 
-   max_node_id = id;
-   max_translated_id = id;
+   while(old <= id) {
+      const node::node_id prev(__sync_val_compare_and_swap(&next_node_id, old, id + 1));
+      if(prev == old)
+         break;
+      old = prev;
+   }
 
-   node *ret(create_fn(max_node_id, max_translated_id));
+   node *ret(create_fn(id, id));
    
-   translation[max_node_id] = max_translated_id;
-   nodes[max_node_id] = ret;
-   nodes_total++;
+   nodes.set(id, ret);
+   __sync_fetch_and_add(&nodes_total, 1);
 
    return ret;
 }
@@ -112,20 +189,11 @@ database::create_node_id(const db::node::node_id id)
 node*
 database::create_node(void)
 {
-   utils::spinlock::scoped_lock l(mtx);
-
-	if(nodes.empty()) {
-		max_node_id = 0;
-		max_translated_id = 0;
-	} else {
-   	++max_node_id;
-   	++max_translated_id;
-	}
-	
-   node *ret(create_fn(max_node_id, max_translated_id));
+   // ids are handed out atomically, the directory takes care of the rest
+   const node::node_id id(__sync_fetch_and_add(&next_node_id, 1));
+   node *ret(create_fn(id, id + translated_offset));
    
-   translation[max_node_id] = max_translated_id;
-   nodes[max_node_id] = ret;
+   nodes.set(id, ret);
 
    return ret;
 }
@@ -142,12 +210,8 @@ database::print_db(ostream& cout) const
    std::vector<db::node*> arr(num_nodes(), NULL);
 
    size_t i(0);
-   for(map_nodes::const_iterator it(nodes.begin());
-      it != nodes.end();
-      ++it)
-   {
-      arr[i++] = it->second;
-   }
+   for(iterator it(nodes.begin()), end(nodes.end()); it != end && i < arr.size(); ++it)
+      arr[i++] = *it;
 
    sort(arr.begin(), arr.end(), node_sorter);
    for(size_t i(0); i < arr.size(); ++i) {
@@ -158,12 +222,8 @@ database::print_db(ostream& cout) const
 void
 database::dump_db(ostream& cout) const
 {
-   for(map_nodes::const_iterator it(nodes.begin());
-      it != nodes.end();
-      ++it)
-   {
-      it->second->dump(cout);
-   }
+   for(iterator it(nodes.begin()), end(nodes.end()); it != end; ++it)
+      (*it)->dump(cout);
 }
 
 #ifdef USE_UI
@@ -178,9 +238,9 @@ database::dump_json(void) const
 	
 	Array nodes_data;
 	
-	for(map_nodes::const_iterator it(nodes.begin()), end(nodes.end()); it != end; it++) {
+	for(iterator it(nodes.begin()), end(nodes.end()); it != end; ++it) {
 		Object node_data;
-		const node *n(it->second);
+		const node *n(*it);
 		
 		UI_ADD_FIELD(node_data, "id", (int)n->get_id());
 		UI_ADD_FIELD(node_data, "translated_id", (int)n->get_translated_id());
@@ -198,13 +258,11 @@ void
 database::print(ostream& cout) const
 {
    cout << "{";
-   for(map_nodes::const_iterator it(nodes.begin());
-      it != nodes.end();
-      ++it)
+   for(iterator it(nodes.begin()), end(nodes.end()); it != end; ++it)
    {
       if(it != nodes.begin())
          cout << ", ";
-      cout << it->first;
+      cout << (*it)->get_id();
    }
    cout << "}";
 }
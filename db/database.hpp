@@ -2,17 +2,15 @@
 #ifndef DATABASE_HPP
 #define DATABASE_HPP
 
-#include <map>
 #include <fstream>
 #include <ostream>
-#include <tr1/unordered_map>
 #include <stdexcept>
 #include <boost/function.hpp>
 #include <boost/static_assert.hpp>
 
 #include "conf.hpp"
 #include "db/node.hpp"
-#include "utils/spinlock.hpp"
+#include "db/node_directory.hpp"
 #include "vm/program.hpp"
 
 #ifdef USE_UI
@@ -27,26 +25,18 @@ class database
 {
 public:
    
-   typedef std::tr1::unordered_map<node::node_id, node::node_id,
-           std::tr1::hash<node::node_id>,
-           std::equal_to<node::node_id>,
-           mem::allocator< std::pair<const node::node_id, node::node_id> > > map_translate;
-   typedef std::map<node::node_id, node*,
-           std::less<node::node_id>,
-           mem::allocator< std::pair<const node::node_id, node*> > > map_nodes;
+   typedef node_directory::iterator iterator;
    typedef boost::function2<node*, node::node_id, node::node_id> create_node_fn;
 
 private:
 
    create_node_fn create_fn;
    
-   map_nodes nodes;
-   map_translate translation;
+   node_directory nodes;
    node::node_id original_max_node_id;
-   node::node_id max_node_id;
-   node::node_id max_translated_id;
-
-	utils::spinlock mtx;
+   // next ids given to nodes created at runtime
+   volatile node::node_id next_node_id;
+   node::node_id translated_offset;
    
 public:
 
@@ -55,12 +45,12 @@ public:
    static const size_t node_size = sizeof(node::node_id) * 2;
    size_t nodes_total;
    
-   map_nodes::const_iterator nodes_begin(void) const { return nodes.begin(); }
-   map_nodes::const_iterator nodes_end(void) const { return nodes.end(); }
-   map_nodes::iterator get_node_iterator(const node::node_id id) { return nodes.find(id); }
+   iterator nodes_begin(void) const { return nodes.begin(); }
+   iterator nodes_end(void) const { return nodes.end(); }
+   iterator get_node_iterator(const node::node_id id) const { return nodes.find(id); }
    
-   size_t num_nodes(void) const { return nodes.size(); }
-   node::node_id max_id(void) const { return max_node_id; }
+   size_t num_nodes(void) const { return nodes.num_nodes(); }
+   node::node_id max_id(void) const { return next_node_id == 0 ? 0 : next_node_id - 1; }
    node::node_id static_max_id(void) const { return original_max_node_id; }
    
    node* find_node(const node::node_id) const;
@@ -11,9 +11,9 @@ namespace db
 {
 
 uint_val
-hash_table::hash_field(const tuple_field field) const
+hash_table::hash_field(const tuple_field field, const field_type type)
 {
-   switch(hash_type) {
+   switch(type) {
       case FIELD_INT: return (uint_val)FIELD_INT(field);
       case FIELD_FLOAT: return (uint_val)FIELD_FLOAT(field);
       case FIELD_NODE:
@@ -34,8 +34,7 @@ hash_table::hash_field(const tuple_field field) const
 size_t
 hash_table::insert(vm::tuple *item)
 {
-   const uint_val id(hash_tuple(item));
-   table_list *bucket(table + (id % size_table));
+   table_list *bucket(locate(item));
    bucket->push_back(item);
    return bucket->get_size();
 }
@@ -43,38 +42,59 @@ hash_table::insert(vm::tuple *item)
 size_t
 hash_table::insert_front(vm::tuple *item)
 {
-   const uint_val id(hash_tuple(item));
-   table_list *bucket(table + (id % size_table));
+   table_list *bucket(locate(item));
    bucket->push_front(item);
    return bucket->get_size();
 }
 
 void
-hash_table::change_table(const size_t new_size_table)
+hash_table::start_resize(const size_t new_size_table)
 {
    assert(new_size_table >= HASH_TABLE_INITIAL_TABLE_SIZE);
 
-   table_list *new_table(alloc().allocate(new_size_table));
-   memset(new_table, 0, sizeof(table_list)*new_size_table);
+   // only one resize at a time
+   while(migrate(old_size));
 
-   for(size_t i(0); i < size_table; ++i) {
-      table_list *ls(table + i);
+   old_table = table;
+   old_size = size_table;
+   old_bits = table_bits;
+   migrated = 0;
+
+   table = alloc().allocate(new_size_table);
+   memset(table, 0, sizeof(table_list)*new_size_table);
+   size_table = new_size_table;
+   table_bits = log2_size(size_table);
+   if(composite)
+      second_bits = table_bits / 2;
+}
+
+bool
+hash_table::migrate(const size_t buckets)
+{
+   if(old_table == NULL)
+      return false;
+
+   const size_t stop(std::min(old_size, migrated + buckets));
+
+   for(; migrated < stop; ++migrated) {
+      table_list *ls(old_table + migrated);
 
       for(table_list::iterator it(ls->begin()), end(ls->end()); it != end; ) {
          vm::tuple *tpl(*it);
          it++;
 
-         const uint_val id(hash_tuple(tpl));
-         table_list *ls(new_table + (id % new_size_table));
-
-         ls->push_back(tpl);
+         table[bucket_for(first_id(tpl), second_id(tpl), table_bits)].push_back(tpl);
       }
    }
 
-   // change pointers
-   alloc().deallocate(table, size_table);
-   table = new_table;
-   size_table = new_size_table;
+   if(migrated < old_size)
+      return true;
+
+   alloc().deallocate(old_table, old_size);
+   old_table = NULL;
+   old_size = 0;
+   migrated = 0;
+   return false;
 }
 
 }
@@ -3,6 +3,7 @@
 #define DB_HASH_TABLE_HPP
 
 #include <assert.h>
+#include <stdint.h>
 #include <ostream>
 #include <iostream>
 
@@ -14,7 +15,10 @@
 namespace db
 {
 
+// tables always have a power of two number of buckets
 #define HASH_TABLE_INITIAL_TABLE_SIZE 8
+// number of old buckets moved into the new table on each migration step
+#define HASH_TABLE_MIGRATE_BUCKETS 64
 
 typedef db::intrusive_list<vm::tuple> table_list;
 
@@ -26,17 +30,73 @@ struct hash_table
 
       table_list *table;
       size_t size_table;
+      size_t table_bits;
       vm::field_num hash_argument;
       vm::field_type hash_type;
+      // composite tables also hash on a second argument.
+      // the bucket index is split in two parts: the high bits come from the first
+      // argument and the low bits from the second, therefore a lookup on only
+      // one of the arguments still needs to look at a subset of the buckets
+      bool composite;
+      vm::field_num hash_argument2;
+      vm::field_type hash_type2;
+      size_t second_bits;
+
+      // while resizing, the buckets of the old table below 'migrated' have
+      // already been moved to the new table and the others are still in use
+      table_list *old_table;
+      size_t old_size;
+      size_t old_bits;
+      size_t migrated;
+
+      static vm::uint_val hash_field(const vm::tuple_field field, const vm::field_type type);
+
+      static inline size_t log2_size(const size_t size)
+      {
+         assert(size > 0 && (size & (size - 1)) == 0);
+         return sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(size);
+      }
+
+      // multiplicative hashing, uses the top 'bits' bits of the product
+      // so that ids that only differ in their high bits are spread too
+      static inline size_t mix(const vm::uint_val id, const size_t bits)
+      {
+         return (size_t)(((uint64_t)id * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+      }
 
-      vm::uint_val hash_field(const vm::tuple_field field) const;
+      inline size_t second_buckets(void) const { return (size_t)1 << second_bits; }
 
-      inline vm::uint_val hash_tuple(vm::tuple *tpl) const
+      inline size_t bucket_for(const vm::uint_val id1, const vm::uint_val id2, const size_t bits) const
       {
-         return hash_field(tpl->get_field(hash_argument));
+         if(!composite)
+            return mix(id1, bits);
+         const size_t low(bits / 2);
+         return (mix(id1, bits - low) << low) | mix(id2, low);
       }
 
-      void change_table(const size_t);
+      inline table_list *locate(const vm::uint_val id1, const vm::uint_val id2)
+      {
+         if(old_table) {
+            const size_t old_bucket(bucket_for(id1, id2, old_bits));
+            if(old_bucket >= migrated)
+               return old_table + old_bucket;
+         }
+         return table + bucket_for(id1, id2, table_bits);
+      }
+
+      inline vm::uint_val first_id(vm::tuple *tpl) const
+      {
+         return hash_field(tpl->get_field(hash_argument), hash_type);
+      }
+
+      inline vm::uint_val second_id(vm::tuple *tpl) const
+      {
+         return composite ? hash_field(tpl->get_field(hash_argument2), hash_type2) : 0;
+      }
+
+      inline table_list *locate(vm::tuple *tpl) { return locate(first_id(tpl), second_id(tpl)); }
+
+      void start_resize(const size_t);
 
    public:
 
@@ -44,19 +104,37 @@ struct hash_table
 
       inline size_t get_num_buckets(void) const { return size_table; }
       inline vm::field_num get_hash_argument(void) const { return hash_argument; }
+      inline bool is_composite(void) const { return composite; }
+      inline vm::field_num get_second_hash_argument(void) const
+      {
+         assert(composite);
+         return hash_argument2;
+      }
 
+      // walks the buckets of the table and then the old buckets not yet migrated
       class iterator
       {
          private:
 
             table_list *bucket;
             table_list *finish;
+            size_t step;
+            table_list *next_bucket;
+            table_list *next_finish;
 
             inline void find_good_bucket(void)
             {
-               for(; bucket != finish; bucket++) {
-                  if(!bucket->empty())
+               while(true) {
+                  for(; bucket != finish; bucket += step) {
+                     if(!bucket->empty())
+                        return;
+                  }
+                  if(next_bucket == next_finish)
                      return;
+                  bucket = next_bucket;
+                  finish = next_finish;
+                  step = 1;
+                  next_bucket = next_finish;
                }
             }
 
@@ -71,27 +149,33 @@ struct hash_table
 
             inline iterator& operator++(void)
             {
-               bucket++;
+               bucket += step;
                find_good_bucket();
                return *this;
             }
 
             inline iterator operator++(int)
             {
-               bucket++;
+               bucket += step;
                find_good_bucket();
                return *this;
             }
 
-            explicit iterator(table_list *start_bucket, table_list *end_bucket):
-               bucket(start_bucket), finish(end_bucket)
+            explicit iterator(table_list *start_bucket, table_list *end_bucket, const size_t _step = 1,
+                  table_list *start_next = NULL, table_list *end_next = NULL):
+               bucket(start_bucket), finish(end_bucket), step(_step),
+               next_bucket(start_next), next_finish(end_next)
             {
                find_good_bucket();
             }
       };
 
-      inline iterator begin(void) { return iterator(table, table + size_table); }
-      inline iterator begin(void) const { return iterator(table, table + size_table); }
+      inline iterator begin(void) const
+      {
+         if(old_table)
+            return iterator(table, table + size_table, 1, old_table + migrated, old_table + old_size);
+         return iterator(table, table + size_table);
+      }
 
       inline size_t get_table_size() const { return size_table; }
 
@@ -100,9 +184,35 @@ struct hash_table
 
       inline db::intrusive_list<vm::tuple>* lookup_list(const vm::tuple_field field)
       {
-         const vm::uint_val id(hash_field(field));
-         table_list *bucket(table + (id % size_table));
-         return bucket;
+         assert(!composite);
+         return locate(hash_field(field, hash_type), 0);
+      }
+
+      // bucket with the tuples matching both arguments of a composite table
+      inline db::intrusive_list<vm::tuple>* lookup_list(const vm::tuple_field field1, const vm::tuple_field field2)
+      {
+         assert(composite);
+         return locate(hash_field(field1, hash_type), hash_field(field2, hash_type2));
+      }
+
+      // buckets with the tuples matching the first argument of a composite table
+      inline iterator lookup_first(const vm::tuple_field field)
+      {
+         assert(composite);
+         if(old_table)
+            return begin();
+         const size_t start(mix(hash_field(field, hash_type), table_bits - second_bits) << second_bits);
+         return iterator(table + start, table + start + second_buckets());
+      }
+
+      // buckets with the tuples matching the second argument of a composite table
+      inline iterator lookup_second(const vm::tuple_field field)
+      {
+         assert(composite);
+         if(old_table)
+            return begin();
+         const size_t start(mix(hash_field(field, hash_type2), second_bits));
+         return iterator(table + start, table + start + size_table, second_buckets());
       }
 
       inline void dump(std::ostream& out, const vm::predicate *pred) const
@@ -117,10 +227,24 @@ struct hash_table
                ls->dump(out, pred);
             }
          }
+         for(size_t i(migrated); old_table && i < old_size; ++i) {
+            table_list *ls(old_table + i);
+            if(!ls->empty()) {
+               out << "Old bucket for " << i << " has " << ls->get_size() << " elements:\n";
+               ls->dump(out, pred);
+            }
+         }
       }
 
-      inline void expand(void) { change_table(size_table * 2); }
-      inline void shrink(void) { change_table(size_table / 2); }
+      // resizing only allocates the new table, the tuples are moved by migrate()
+      inline void expand(void) { start_resize(size_table * 2); }
+      inline void shrink(void) { start_resize(size_table / 2); }
+
+      inline bool is_resizing(void) const { return old_table != NULL; }
+
+      // moves up to 'buckets' old buckets into the new table.
+      // returns true while there are old buckets left
+      bool migrate(const size_t buckets = HASH_TABLE_MIGRATE_BUCKETS);
 
       inline bool too_crowded(void) const
       {
@@ -153,14 +277,32 @@ struct hash_table
       {
          hash_argument = field;
          hash_type = type;
+         composite = false;
          next_expand = NULL;
+         old_table = NULL;
+         old_size = 0;
+         migrated = 0;
          size_table = default_table_size;
+         table_bits = log2_size(size_table);
          table = alloc().allocate(size_table);
          memset(table, 0, sizeof(table_list)*size_table);
       }
 
+      inline void setup(const vm::field_num field1, const vm::field_type type1,
+            const vm::field_num field2, const vm::field_type type2,
+            const size_t default_table_size = HASH_TABLE_INITIAL_TABLE_SIZE)
+      {
+         setup(field1, type1, default_table_size);
+         composite = true;
+         hash_argument2 = field2;
+         hash_type2 = type2;
+         second_bits = table_bits / 2;
+      }
+
       inline void destroy(void)
       {
+         if(old_table)
+            alloc().deallocate(old_table, old_size);
          alloc().deallocate(table, size_table);
       }
 };
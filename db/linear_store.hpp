@@ -33,6 +33,10 @@ struct linear_store
       utils::spinlock internal;
 
       hash_table *expand;
+      // number of tables that are moving their buckets into a resized table
+      size_t resizing;
+      // first predicate of the next compaction pass
+      vm::predicate_id compact_next;
 
    private:
 
@@ -46,12 +50,33 @@ struct linear_store
          return (hash_table*)(data + ITEM_SIZE * p);
       }
 
+      static inline void setup_table(hash_table *table, const vm::predicate *pred,
+            const size_t size_table = HASH_TABLE_INITIAL_TABLE_SIZE)
+      {
+         const vm::field_num field(pred->get_hashed_field());
+         if(pred->has_composite_hash()) {
+            const vm::field_num field2(pred->get_second_hashed_field());
+            table->setup(field, pred->get_field_type(field)->get_type(),
+                  field2, pred->get_field_type(field2)->get_type(), size_table);
+         } else
+            table->setup(field, pred->get_field_type(field)->get_type(), size_table);
+      }
+
+      // checks if the table is indexed by the fields the predicate wants
+      static inline bool same_index(const hash_table *table, const vm::predicate *pred)
+      {
+         if(table->get_hash_argument() != pred->get_hashed_field())
+            return false;
+         if(table->is_composite() != pred->has_composite_hash())
+            return false;
+         return !table->is_composite() || table->get_second_hash_argument() == pred->get_second_hashed_field();
+      }
+
       inline hash_table* create_table(const vm::predicate *pred)
       {
          hash_table *table(get_table(pred->get_id()));
          mem::allocator<hash_table>().construct(table);
-         const vm::field_num field(pred->get_hashed_field());
-         table->setup(field, pred->get_field_type(field)->get_type());
+         setup_table(table, pred);
          return table;
       }
 
@@ -76,8 +101,7 @@ struct linear_store
       {
          const size_t size_table(tbl->get_num_buckets());
          hash_table new_hash;
-         const vm::field_num field(pred->get_hashed_field());
-         new_hash.setup(field, pred->get_field_type(field)->get_type(), size_table);
+         setup_table(&new_hash, pred, size_table);
 
          hash_table::iterator it(tbl->begin());
 
@@ -241,15 +265,32 @@ struct linear_store
          }
       }
 
+      // resized tables move a few buckets at a time so that
+      // a big table does not stall the node
+      inline void migrate_tables(void)
+      {
+         resizing = 0;
+         for(vm::bitmap::iterator it(types.begin(vm::theProgram->num_predicates())); !it.end(); ++it) {
+            hash_table *tbl(get_table(*it));
+
+            if(tbl->migrate())
+               resizing++;
+         }
+      }
+
       inline void improve_index(void)
       {
          while(expand) {
             hash_table *next(expand->next_expand);
             expand->next_expand = NULL;
-            if(expand->too_crowded())
+            if(!expand->is_resizing() && expand->too_crowded()) {
                expand->expand();
+               resizing++;
+            }
             expand = next;
          }
+         if(resizing > 0)
+            migrate_tables();
       }
 
       inline void cleanup_index(void)
@@ -258,15 +299,68 @@ struct linear_store
             const vm::predicate_id id(*it);
             hash_table *tbl(get_table(id));
 
+            if(tbl->is_resizing())
+               continue;
+
             if(tbl->too_sparse()) {
                if(tbl->smallest_possible())
                   transform_hash_table_to_list(tbl, vm::theProgram->get_predicate(id));
-               else
+               else {
                   tbl->shrink();
+                  resizing++;
+               }
             }
          }
       }
 
+      // moves the tuples of the list next to each other (in list order)
+      static inline size_t compact_list(tuple_list *ls, const vm::predicate *pred)
+      {
+         tuple_list moved;
+
+         for(tuple_list::iterator it(ls->begin()), end(ls->end()); it != end; ) {
+            vm::tuple *tpl(*it);
+            it++;
+            moved.push_back(vm::tuple::relocate(tpl, pred));
+         }
+
+         const size_t total(moved.get_size());
+         ls->clear();
+         ls->splice_back(moved);
+         return total;
+      }
+
+      // relocates the tuples of each predicate into contiguous memory.
+      // starts where the previous pass stopped and stops after
+      // the predicate that makes it move more than 'budget' tuples
+      inline void compact(const size_t budget)
+      {
+         const size_t num_preds(vm::theProgram->num_predicates());
+         size_t moved(0);
+
+         for(size_t i(0); i < num_preds && moved < budget; ++i) {
+            const vm::predicate_id id((compact_next + i) % num_preds);
+            const vm::predicate *pred(vm::theProgram->get_predicate(id));
+
+            if(!pred->is_linear_pred())
+               continue;
+
+            if(stored_as_hash_table(pred)) {
+               hash_table *tbl(get_table(id));
+
+               for(hash_table::iterator it(tbl->begin()); !it.end(); ++it)
+                  moved += compact_list(*it, pred);
+            } else {
+               tuple_list *ls(get_list(id));
+
+               if(ls->get_size() >= CREATE_HASHTABLE_THREADSHOLD)
+                  moved += compact_list(ls, pred);
+            }
+
+            compact_next = (id + 1) % num_preds;
+         }
+      }
+
       inline void rebuild_index(void)
       {
          for(size_t i(0); i < vm::theProgram->num_predicates(); ++i) {
@@ -278,9 +372,8 @@ struct linear_store
             if(pred->is_hash_table()) {
                if(stored_as_hash_table(pred)) {
                   hash_table *tbl(get_hash_table(i));
-                  // check if using the correct argument
-                  const vm::field_num old(tbl->get_hash_argument());
-                  if(old != pred->get_hashed_field()) {
+                  // check if using the correct arguments
+                  if(!same_index(tbl, pred)) {
                      transform_hash_table_new_field(tbl, pred);
                   } else {
                      // do nothing
@@ -311,6 +404,8 @@ struct linear_store
             mem::allocator<tuple_list>().construct((tuple_list*)p);
          }
          expand = NULL;
+         resizing = 0;
+         compact_next = 0;
       }
 
       inline void destroy(void) {
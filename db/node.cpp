@@ -117,6 +117,19 @@ node::match_predicate(const predicate_id id, const match* m) const
    return tr->match_predicate(m);
 }
 
+#ifdef TRIE_FILTERS
+bool
+node::may_match(const predicate_id id, const match* m) const
+{
+   simple_tuple_map::const_iterator it(tuples.find(id));
+
+   if(it == tuples.end())
+      return false;
+
+   return it->second->may_match(m);
+}
+#endif
+
 void
 node::delete_all(const predicate*)
 {
@@ -181,7 +194,10 @@ node::assert_end(void) const
 
 node::node(const node_id _id, const node_id _trans):
    id(_id), translation(_trans), owner(NULL), linear(),
-   store(), unprocessed_facts(false), running(false),
+   store(), unprocessed_facts(false), running(false), yielded(false),
+#ifdef NODE_LATENCY_STATISTICS
+   pending_since(0), latency_max(0), latency_total(0), latency_runs(0),
+#endif
    rounds(0), indexing_epoch(0)
 {
 }
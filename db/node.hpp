@@ -24,6 +24,9 @@
 #include "vm/all.hpp"
 #include "db/linear_store.hpp"
 #include "vm/temporary.hpp"
+#ifdef NODE_LATENCY_STATISTICS
+#include "utils/time.hpp"
+#endif
 
 #ifdef USE_UI
 #include <json_spirit.h>
@@ -99,6 +102,10 @@ public:
    
    db::tuple_trie::tuple_search_iterator match_predicate(const vm::predicate_id) const;
   	db::tuple_trie::tuple_search_iterator match_predicate(const vm::predicate_id, const vm::match*) const;
+#ifdef TRIE_FILTERS
+   // false if match_predicate is sure to find no tuples
+   bool may_match(const vm::predicate_id, const vm::match*) const;
+#endif
    
    size_t count_total(const vm::predicate_id) const;
    
@@ -112,6 +119,14 @@ public:
    vm::temporary_store store;
    volatile bool unprocessed_facts;
    bool running;
+   // ran out of its quota with rules left to run
+   bool yielded;
+#ifdef NODE_LATENCY_STATISTICS
+   uint64_t pending_since; // when the node got facts to process
+   uint64_t latency_max;
+   uint64_t latency_total;
+   size_t latency_runs;
+#endif
    uint16_t rounds;
    vm::deterministic_timestamp indexing_epoch;
 
@@ -119,14 +134,33 @@ public:
    inline void unlock(void) { store.spin.unlock(); }
    inline void internal_lock(void) { linear.internal.lock(); }
    inline void internal_unlock(void) { linear.internal.unlock(); }
+   inline void mark_unprocessed(void)
+   {
+#ifdef NODE_LATENCY_STATISTICS
+      if(!unprocessed_facts)
+         pending_since = utils::get_nanoseconds();
+#endif
+      unprocessed_facts = true;
+   }
    inline void add_linear_fact(vm::tuple *tpl, vm::predicate *pred)
    {
       store.register_tuple_fact(pred, 1);
       linear.add_fact(tpl, pred, store.matcher);
    }
+   // the node ran out of its quota in the middle of a derivation
+   inline bool is_suspended(void) const
+   {
+      return !store.matcher.pending_rules.empty(vm::theProgram->num_rules_next_uint());
+   }
    inline void add_work_myself(vm::tuple *tpl, vm::predicate *pred, const vm::ref_count count, const vm::depth_t depth)
    {
-      unprocessed_facts = true;
+      if(is_suspended()) {
+         // the facts wait until the rules saved by the node have run
+         add_work_others(tpl, pred, count, depth);
+         return;
+      }
+
+      mark_unprocessed();
 
       if(pred->is_action_pred())
          store.add_action_fact(new simple_tuple(tpl, pred, count, depth));
@@ -138,16 +172,44 @@ public:
          add_linear_fact(tpl, pred);
    }
 
+   // the fact comes from a node of the owner thread and this node is not running.
+   // linear facts go to the linear store and new persistent facts are staged
+   // without a simple_tuple, returns false if add_work_myself must be used
+   inline bool add_local_fact(vm::tuple *tpl, vm::predicate *pred, const vm::ref_count count, const vm::depth_t depth)
+   {
+      if(is_suspended() || pred->is_action_pred() || pred->is_reused_pred())
+         return false;
+
+      if(pred->is_linear_pred()) {
+         mark_unprocessed();
+         add_linear_fact(tpl, pred);
+         return true;
+      }
+
+      // the tuple must be processed before the staged ones, which
+      // may include deletions or aggregates
+      if(count != 1 || depth != 0 || pred->is_aggregate_pred() ||
+            !store.persistent_tuples.empty() || store.has_incoming_persistent())
+         return false;
+
+      mark_unprocessed();
+      store.local_persistent.push_back(tpl);
+      store.register_tuple_fact(pred, count);
+#ifdef MEMORY_STATISTICS
+      mem::register_avoided_allocation();
+#endif
+      return true;
+   }
+
    inline void add_work_others(vm::tuple *tpl, vm::predicate *pred, const vm::ref_count count, const vm::depth_t depth)
    {
-      unprocessed_facts = true;
+      mark_unprocessed();
 
       if(pred->is_action_pred()) {
          simple_tuple *stpl(new simple_tuple(tpl, pred, count, depth));
          store.incoming_action_tuples.push_back(stpl);
       } else if(pred->is_persistent_pred() || pred->is_reused_pred()) {
-         simple_tuple *stpl(new simple_tuple(tpl, pred, count, depth));
-         store.incoming_persistent_tuples.push_back(stpl);
+         store.add_incoming_persistent(new simple_tuple(tpl, pred, count, depth));
       } else
          store.add_incoming(tpl, pred);
    }
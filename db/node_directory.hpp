@@ -0,0 +1,175 @@
+
+#ifndef DB_NODE_DIRECTORY_HPP
+#define DB_NODE_DIRECTORY_HPP
+
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+
+#include "db/node.hpp"
+
+namespace db
+{
+
+// maps node ids to nodes using a dense table made of segments of doubling size.
+// segments are never moved or freed while the database is alive, so lookups
+// do not need any lock and new nodes can be added while other threads read the table
+class node_directory
+{
+private:
+
+   static const size_t FIRST_SEGMENT_BITS = 10;
+   static const size_t FIRST_SEGMENT_SIZE = 1 << FIRST_SEGMENT_BITS;
+   static const size_t MAX_SEGMENTS = 48;
+
+   node ** volatile segments[MAX_SEGMENTS];
+   // one past the largest id in the table
+   volatile node::node_id limit;
+   volatile size_t count;
+
+   static inline size_t segment_of(const node::node_id id, size_t *offset)
+   {
+      const size_t pos(id + FIRST_SEGMENT_SIZE);
+      const size_t bit(sizeof(unsigned long long) * 8 - 1 - __builtin_clzll(pos));
+
+      *offset = pos - ((size_t)1 << bit);
+      return bit - FIRST_SEGMENT_BITS;
+   }
+
+   static inline size_t segment_size(const size_t seg)
+   {
+      return FIRST_SEGMENT_SIZE << seg;
+   }
+
+   inline node **get_segment(const size_t seg)
+   {
+      assert(seg < MAX_SEGMENTS);
+
+      node **ret(segments[seg]);
+
+      if(ret == NULL) {
+         node **fresh(new node*[segment_size(seg)]);
+
+         memset(fresh, 0, sizeof(node*) * segment_size(seg));
+         if(__sync_bool_compare_and_swap(segments + seg, NULL, fresh))
+            ret = fresh;
+         else {
+            // some other thread installed it first
+            delete []fresh;
+            ret = segments[seg];
+         }
+      }
+
+      return ret;
+   }
+
+public:
+
+   // iterates over the nodes with ids in [first, last)
+   class iterator
+   {
+   private:
+
+      const node_directory *dir;
+      node::node_id id;
+
+      inline void skip(void)
+      {
+         const node::node_id end(dir->size());
+
+         while(id < end && dir->get(id) == NULL)
+            ++id;
+      }
+
+   public:
+
+      inline node* operator*(void) const { return dir->get(id); }
+
+      inline iterator& operator++(void)
+      {
+         ++id;
+         skip();
+         return *this;
+      }
+
+      inline bool operator==(const iterator& other) const { return id == other.id; }
+      inline bool operator!=(const iterator& other) const { return id != other.id; }
+
+      explicit iterator(const node_directory *_dir, const node::node_id _id):
+         dir(_dir), id(std::min(_id, _dir->size()))
+      {
+         skip();
+      }
+   };
+
+   inline node* get(const node::node_id id) const
+   {
+      size_t offset;
+      const size_t seg(segment_of(id, &offset));
+
+      if(seg >= MAX_SEGMENTS)
+         return NULL;
+
+      node **segment(segments[seg]);
+
+      if(segment == NULL)
+         return NULL;
+
+      return segment[offset];
+   }
+
+   inline void set(const node::node_id id, node *n)
+   {
+      size_t offset;
+      node **segment(get_segment(segment_of(id, &offset)));
+
+      assert(segment[offset] == NULL);
+
+      // the node must be fully built before it becomes visible
+      __sync_synchronize();
+      segment[offset] = n;
+      __sync_fetch_and_add(&count, 1);
+
+      node::node_id old(limit);
+      while(old <= id) {
+         const node::node_id prev(__sync_val_compare_and_swap(&limit, old, id + 1));
+         if(prev == old)
+            break;
+         old = prev;
+      }
+   }
+
+   // number of nodes in the table
+   inline size_t num_nodes(void) const { return count; }
+   // one past the largest id
+   inline node::node_id size(void) const { return limit; }
+   inline bool empty(void) const { return count == 0; }
+
+   inline iterator begin(void) const { return iterator(this, 0); }
+   inline iterator end(void) const { return iterator(this, limit); }
+   // iterator to the node with the given id or end() if there is no such node
+   inline iterator find(const node::node_id id) const
+   {
+      if(get(id) == NULL)
+         return end();
+      return iterator(this, id);
+   }
+
+   explicit node_directory(void):
+      limit(0), count(0)
+   {
+      memset((void*)segments, 0, sizeof(segments));
+   }
+
+   ~node_directory(void)
+   {
+      for(size_t i(0); i < MAX_SEGMENTS; ++i) {
+         if(segments[i])
+            delete []segments[i];
+      }
+   }
+};
+
+}
+
+#endif
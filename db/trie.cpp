@@ -14,9 +14,56 @@ namespace db
 {
 
 static const size_t STACK_EXTRA_SIZE(3);
+// starting values and limits of the per predicate trie_level_policy
 static const size_t TRIE_HASH_LIST_THRESHOLD(8);
+static const size_t TRIE_HASH_MIN_LIST_THRESHOLD(4);
+static const size_t TRIE_HASH_MAX_LIST_THRESHOLD(64);
 static const size_t TRIE_HASH_BASE_BUCKETS(64);
-static const size_t TRIE_HASH_MAX_NODES_PER_BUCKET(TRIE_HASH_LIST_THRESHOLD / 2);
+static const size_t TRIE_HASH_MIN_BUCKETS(16);
+static const size_t TRIE_HASH_MAX_BUCKETS(1024);
+static const size_t TRIE_HASH_MAX_NODES_PER_BUCKET(4);
+// votes needed before the policy of a predicate changes
+static const int TRIE_POLICY_VOTES(16);
+
+static trie_level_policy policies[1 << (8 * sizeof(predicate_id))];
+
+trie_level_policy*
+trie_level_policy::get(const predicate *pred)
+{
+   trie_level_policy *policy(policies + pred->get_id());
+
+   if(policy->list_threshold == 0) {
+      policy->base_buckets = TRIE_HASH_BASE_BUCKETS;
+      policy->votes = 0;
+      policy->list_threshold = TRIE_HASH_LIST_THRESHOLD;
+   }
+
+   return policy;
+}
+
+void
+trie_level_policy::hash_released(const size_t peak)
+{
+   // the values would have fit in a list
+   if(peak > 2 * list_threshold)
+      return;
+
+   if(++votes >= TRIE_POLICY_VOTES) {
+      list_threshold = min(list_threshold * 2, TRIE_HASH_MAX_LIST_THRESHOLD);
+      base_buckets = max(base_buckets / 2, TRIE_HASH_MIN_BUCKETS);
+      votes = 0;
+   }
+}
+
+void
+trie_level_policy::hash_expanded(void)
+{
+   if(--votes <= -TRIE_POLICY_VOTES) {
+      list_threshold = max(list_threshold / 2, TRIE_HASH_MIN_LIST_THRESHOLD);
+      base_buckets = min(base_buckets * 2, TRIE_HASH_MAX_BUCKETS);
+      votes = 0;
+   }
+}
 
 size_t
 trie_hash::count_refs(void) const
@@ -291,6 +338,8 @@ trie_node::insert(const tuple_field& field, type *t, match_stack& mstk)
 		trie_hash *hash((trie_hash*)child);
       
       hash->total++;
+      if(hash->total > hash->peak)
+         hash->peak = hash->total;
       
       switch(t->get_type()) {
          case FIELD_LIST: {
@@ -327,12 +376,12 @@ trie_node::insert(const tuple_field& field, type *t, match_stack& mstk)
 
 // put all children into hash table
 void
-trie_node::convert_hash(type *type)
+trie_node::convert_hash(type *type, trie_level_policy *policy)
 {
    assert(!is_hashed());
    
    trie_node *next(get_child());
-   trie_hash *hash(new trie_hash(type, this));
+   trie_hash *hash(new trie_hash(type, this, policy));
    size_t total(0);
    
    while (next != NULL) {
@@ -361,7 +410,7 @@ trie_node::convert_hash(type *type)
       next = tmp;
    }
    
-   hash->total = total;
+   hash->total = hash->peak = total;
    child = (trie_node*)hash;
 	assert(!is_hashed());
 	hashed = true;
@@ -480,6 +529,8 @@ trie_hash::expand(void)
 {
    const size_t old_num_buckets(num_buckets);
    trie_node **old_buckets(buckets);
+
+   policy->hash_expanded();
    
    num_buckets *= 2;
    buckets = allocator<trie_node*>().allocate(num_buckets);
@@ -513,11 +564,11 @@ trie_hash::expand(void)
    allocator<trie_node*>().deallocate(old_buckets, old_num_buckets);
 }
 
-trie_hash::trie_hash(vm::type *_type, trie_node *_parent):
-   type(_type), parent(_parent), total(0)
+trie_hash::trie_hash(vm::type *_type, trie_node *_parent, trie_level_policy *_policy):
+   type(_type), parent(_parent), total(0), peak(0), policy(_policy)
 {
-   buckets = allocator<trie_node*>().allocate(TRIE_HASH_BASE_BUCKETS);
-   num_buckets = TRIE_HASH_BASE_BUCKETS;
+   num_buckets = policy->base_buckets;
+   buckets = allocator<trie_node*>().allocate(num_buckets);
    memset(buckets, 0, sizeof(trie_node*)*num_buckets);
 }
 
@@ -559,6 +610,7 @@ trie::delete_path(trie_node *node)
          trie_hash *hash(parent->get_hash());
          
          if(hash->total == 0) {
+            hash->policy->hash_released(hash->peak);
             delete hash;
 				node->hashed = false;
 				node->bucket = NULL;
@@ -682,6 +734,7 @@ trie::check_insert(void *data, predicate *pred, const derivation_count many, con
    }
    
    trie_node *parent(root);
+   trie_level_policy *policy(trie_level_policy::get(pred));
    
    while (!parent->is_leaf()) {
       assert(!mstk.empty());
@@ -705,8 +758,8 @@ trie::check_insert(void *data, predicate *pred, const derivation_count many, con
          
          ++count;
          
-         if(count > TRIE_HASH_LIST_THRESHOLD && !parent->is_hashed()) {
-            parent->convert_hash(typ);
+         if(!parent->is_hashed() && count > policy->list_threshold) {
+            parent->convert_hash(typ, policy);
             assert(parent->is_hashed());
          } else if (parent->is_hashed() && count > TRIE_HASH_MAX_NODES_PER_BUCKET) {
             assert(parent->is_hashed());
@@ -957,10 +1010,36 @@ tuple_trie::insert_tuple(vm::tuple *tpl, vm::predicate *pred, const derivation_c
    basic_invariants();
    
    const bool is_new(!found);
+
+#ifdef TRIE_FILTERS
+   if(is_new && tuple_filter::usable(pred)) {
+      if(!filter.active() || filter.must_rebuild())
+         rebuild_filter(pred);
+      else
+         filter.add(tuple_filter::key(tpl->get_field(0), pred->get_field_type(0)->get_type()));
+   }
+#endif
    
    return is_new;
 }
 
+#ifdef TRIE_FILTERS
+void
+tuple_trie::rebuild_filter(vm::predicate *pred)
+{
+   const field_type typ(pred->get_field_type(0)->get_type());
+   size_t count(0);
+
+   for(trie_leaf *leaf(first_leaf); leaf; leaf = leaf->next)
+      ++count;
+
+   filter.reset(count);
+
+   for(tuple_trie_leaf *leaf((tuple_trie_leaf*)first_leaf); leaf; leaf = (tuple_trie_leaf*)leaf->next)
+      filter.add(tuple_filter::key(leaf->get_underlying_tuple()->get_field(0), typ));
+}
+#endif
+
 trie::delete_info
 tuple_trie::delete_tuple(vm::tuple *tpl, vm::predicate *pred, const derivation_count many, const depth_t depth)
 {
@@ -980,6 +1059,10 @@ tuple_trie::delete_tuple(vm::tuple *tpl, vm::predicate *pred, const derivation_c
    trie_leaf *leaf(node->get_leaf());
    
    if(leaf->to_delete()) {
+#ifdef TRIE_FILTERS
+      if(filter.active())
+         filter.remove();
+#endif
       // for this branch, we will decrease number_of_references later
       // in commit_delete
       return delete_info((tuple_trie_leaf*)leaf, this, true, node, many);
@@ -11,6 +11,7 @@
 #include "vm/tuple.hpp"
 #include "vm/defs.hpp"
 #include "db/tuple.hpp"
+#include "db/tuple_filter.hpp"
 #include "vm/predicate.hpp"
 #include "vm/match.hpp"
 #include "vm/types.hpp"
@@ -25,6 +26,26 @@ class tuple_trie_leaf;
 typedef std::list<simple_tuple*, mem::allocator<simple_tuple*> > simple_tuple_list;
 typedef std::vector<tuple_trie_leaf*, mem::allocator<tuple_trie_leaf*> > tuple_vector;
 
+// when trie levels of a predicate become hash tables and how big they start.
+// learned at runtime from the hash tables that are created and released,
+// shared by all the nodes (the updates are racy, but this is only a hint)
+struct trie_level_policy
+{
+   // sibling lists longer than this become hash tables
+   size_t list_threshold;
+   // initial number of buckets of new hash tables
+   size_t base_buckets;
+   // votes of hash tables that stayed small (positive) or grew large (negative)
+   int votes;
+
+   // a hash table was released after holding at most 'peak' values
+   void hash_released(const size_t peak);
+   // a hash table had to grow
+   void hash_expanded(void);
+
+   static trie_level_policy *get(const vm::predicate *);
+};
+
 class trie_node: public mem::base
 {
 public:
@@ -45,7 +66,7 @@ public:
    trie_node* get_by_float(const vm::float_val) const;
    trie_node* get_by_node(const vm::node_val) const;
    
-   void convert_hash(vm::type*);
+   void convert_hash(vm::type*, trie_level_policy *);
 
    inline bool is_hashed(void) const { return hashed; }
    inline trie_hash* get_hash(void) const { return (trie_hash*)child; }
@@ -112,6 +133,8 @@ private:
    trie_node **buckets;
    size_t num_buckets;
    size_t total;
+   size_t peak; // largest total seen
+   trie_level_policy *policy;
    
    inline size_t hash_item(const size_t item) const { return item & (num_buckets-1); }
    
@@ -133,7 +156,7 @@ public:
 
    void expand(void);
    
-   explicit trie_hash(vm::type *, trie_node*);
+   explicit trie_hash(vm::type *, trie_node*, trie_level_policy *);
    
    ~trie_hash(void);
 };
@@ -377,17 +400,18 @@ public:
    
    virtual inline bool to_delete(void) const { return count == 0; }
    
-   explicit tuple_trie_leaf(simple_tuple *_tpl):
+   // the leaf takes ownership of the tuple
+   explicit tuple_trie_leaf(vm::tuple *_tpl, vm::predicate *pred, const vm::ref_count many, const vm::depth_t depth):
       trie_leaf(),
-      tpl(_tpl->get_tuple()),
+      tpl(_tpl),
       count(0),
       used(0)
    {
-      if(_tpl->get_predicate()->is_cycle_pred())
+      if(pred->is_cycle_pred())
          depths = new depth_counter();
       else
          depths = NULL;
-      add_new(_tpl->get_depth(), _tpl->get_count());
+      add_new(depth, many);
    }
 
    virtual void destroy(vm::predicate *pred)
@@ -568,13 +592,19 @@ private:
 
    virtual trie_leaf* create_leaf(void *data, vm::predicate *pred, const vm::ref_count many, const vm::depth_t depth)
    {
-      return new tuple_trie_leaf(new simple_tuple((vm::tuple*)data, pred, many, depth));
+      return new tuple_trie_leaf((vm::tuple*)data, pred, many, depth);
    }
    
    trie_node* check_insert(vm::tuple *, vm::predicate *, const vm::derivation_count, const vm::depth_t, bool&);
 
    void visit(trie_node *n, vm::predicate *pred) const;
    void do_visit(trie_node *, const int, std::stack<vm::type*>&) const;
+
+#ifdef TRIE_FILTERS
+   tuple_filter filter;
+
+   void rebuild_filter(vm::predicate *);
+#endif
    
 public:
 
@@ -690,12 +720,28 @@ public:
    
    tuple_search_iterator match_predicate(const vm::match*) const;
 
+#ifdef TRIE_FILTERS
+   // false if no tuple can have the first argument fixed by the match object
+   inline bool may_match(const vm::match *m) const
+   {
+      if(!filter.active() || !m->has_match(0))
+         return true;
+      const vm::match_field f(m->get_match(0));
+      return filter.may_contain(tuple_filter::key(f.field, f.ty->get_type()));
+   }
+#endif
+
    tuple_search_iterator match_predicate(void) const;
 	static inline tuple_search_iterator match_end(void) { return tuple_search_iterator(); }
    
    explicit tuple_trie(void): trie() { basic_invariants(); }
    
-   virtual ~tuple_trie(void) {}
+   virtual ~tuple_trie(void)
+   {
+#ifdef TRIE_FILTERS
+      filter.destroy();
+#endif
+   }
 };
 
 class agg_configuration;
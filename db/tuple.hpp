@@ -34,6 +34,9 @@ private:
 
 public:
 
+   // link used while the tuple is staged in vm::temporary_store
+   simple_tuple *next_incoming;
+
    MEM_METHODS(simple_tuple)
 
    inline vm::tuple* get_tuple(void) const { return data; }
@@ -74,11 +77,11 @@ public:
 
    explicit simple_tuple(vm::tuple *_tuple, vm::predicate *_pred, const vm::derivation_count _count, const vm::depth_t _depth = 0):
       pred(_pred), data(_tuple), count(_count), depth(_depth),
-      is_final_aggregate(false)
+      is_final_aggregate(false), next_incoming(NULL)
    {}
 
    explicit simple_tuple(void): // for serialization purposes
-      is_final_aggregate(false)
+      is_final_aggregate(false), next_incoming(NULL)
    {
    }
 
@@ -0,0 +1,124 @@
+
+#ifndef DB_TUPLE_FILTER_HPP
+#define DB_TUPLE_FILTER_HPP
+
+#include <stdint.h>
+#include <string.h>
+
+#include "conf.hpp"
+#include "mem/allocator.hpp"
+#include "vm/defs.hpp"
+#include "vm/predicate.hpp"
+
+namespace db
+{
+
+// words of the smallest filter (a power of two)
+#define TUPLE_FILTER_MIN_WORDS 8
+// bits of the filter per key
+#define TUPLE_FILTER_BITS_PER_KEY 16
+
+// blocked bloom filter over the first argument of the tuples of a trie.
+// the three bits of a key are in the same 64 bit word, so a lookup touches
+// a single word. deleted keys are only forgotten when the filter is rebuilt
+struct tuple_filter
+{
+   private:
+
+      uint64_t *words;
+      size_t num_words;
+      size_t keys; // keys added since the last rebuild
+      size_t deleted; // keys deleted since the last rebuild
+
+      static inline uint64_t mix(uint64_t key)
+      {
+         key ^= key >> 33;
+         key *= 0xff51afd7ed558ccdULL;
+         key ^= key >> 33;
+         key *= 0xc4ceb9fe1a85ec53ULL;
+         key ^= key >> 33;
+         return key;
+      }
+
+      static inline uint64_t bits(const uint64_t h)
+      {
+         return ((uint64_t)1 << (h & 63)) | ((uint64_t)1 << ((h >> 6) & 63)) | ((uint64_t)1 << ((h >> 12) & 63));
+      }
+
+      inline uint64_t *word(const uint64_t h) const { return words + ((h >> 32) & (num_words - 1)); }
+
+   public:
+
+      // only int and node arguments have a single representation that can be hashed
+      static inline bool usable(const vm::predicate *pred)
+      {
+         if(pred->num_fields() == 0)
+            return false;
+         const vm::field_type typ(pred->get_field_type(0)->get_type());
+         return typ == vm::FIELD_INT || typ == vm::FIELD_NODE;
+      }
+
+      static inline uint64_t key(const vm::tuple_field f, const vm::field_type typ)
+      {
+         if(typ == vm::FIELD_INT)
+            return (uint64_t)FIELD_INT(f);
+         return (uint64_t)FIELD_NODE(f);
+      }
+
+      inline bool active(void) const { return words != NULL; }
+
+      inline void add(const uint64_t k)
+      {
+         const uint64_t h(mix(k));
+         *word(h) |= bits(h);
+         ++keys;
+      }
+
+      inline bool may_contain(const uint64_t k) const
+      {
+         const uint64_t h(mix(k));
+         const uint64_t b(bits(h));
+         return (*word(h) & b) == b;
+      }
+
+      inline void remove(void) { ++deleted; }
+
+      // too many keys for its size or too many deleted keys
+      inline bool must_rebuild(void) const
+      {
+         return keys * TUPLE_FILTER_BITS_PER_KEY > num_words * 64 || deleted * 2 > keys;
+      }
+
+      // clears the filter and makes room for 'expected' keys
+      inline void reset(const size_t expected)
+      {
+         size_t size(TUPLE_FILTER_MIN_WORDS);
+         while(size * 64 < expected * TUPLE_FILTER_BITS_PER_KEY * 2)
+            size *= 2;
+
+         if(size != num_words) {
+            destroy();
+            words = mem::allocator<uint64_t>().allocate(size);
+            num_words = size;
+         }
+         memset(words, 0, sizeof(uint64_t) * num_words);
+         keys = 0;
+         deleted = 0;
+      }
+
+      inline void destroy(void)
+      {
+         if(words)
+            mem::allocator<uint64_t>().deallocate(words, num_words);
+         words = NULL;
+         num_words = 0;
+      }
+
+      explicit tuple_filter(void):
+         words(NULL), num_words(0), keys(0), deleted(0)
+      {}
+};
+
+}
+
+#endif
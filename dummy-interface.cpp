@@ -26,6 +26,13 @@ bool show_database = false;
 bool dump_database = false;
 bool time_execution = false;
 bool memory_statistics = false;
+bool numa_mode = false;
+bool predecoded_mode = false;
+bool full_aggregates_mode = false;
+bool compact_mode = false;
+size_t bucket_width = 1;
+size_t node_quota = 0;
+bool latency_statistics = false;
 
 void
 parse_sched(char *sched)
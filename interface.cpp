@@ -26,6 +26,13 @@ bool show_database = false;
 bool dump_database = false;
 bool time_execution = false;
 bool memory_statistics = false;
+bool numa_mode = false;
+bool predecoded_mode = false;
+bool full_aggregates_mode = false;
+bool compact_mode = false;
+size_t bucket_width = 1;
+size_t node_quota = 0;
+bool latency_statistics = false;
 
 static inline size_t
 num_cpus_available(void)
@@ -91,6 +98,7 @@ parse_sched(char *sched)
    
    // attempt to parse the scheduler string
    match_threads("thp", sched, SCHED_THREADS_PRIO) ||
+      match_threads("mq", sched, SCHED_THREADS_MQ) ||
       match_threads("th", sched, SCHED_THREADS) ||
       match_serial("sl", sched, SCHED_SERIAL) ||
 		match_serial("ui", sched, SCHED_SERIAL_UI) ||
@@ -110,6 +118,7 @@ help_schedulers(void)
 	cerr << "\t\t\tui serial scheduler + ui" << endl;
    cerr << "\t\t\tthX multithreaded scheduler with task stealing" << endl;
    cerr << "\t\t\tthpX multithreaded scheduler with priorities and task stealing" << endl;
+   cerr << "\t\t\tmqX multithreaded scheduler with relaxed shared priority queues" << endl;
 }
 
 static inline void
@@ -126,6 +135,7 @@ run_program(int argc, char **argv, const char *program, const vm::machine_argume
 	try {
       double start_time(0.0);
       execution_time tm;
+      size_t start_cpu(0);
 
       (void)start_time;
       
@@ -137,6 +147,7 @@ run_program(int argc, char **argv, const char *program, const vm::machine_argume
 #endif
          {
             tm.start();
+            start_cpu = get_cpu_time();
          }
       }
 
@@ -165,8 +176,14 @@ run_program(int argc, char **argv, const char *program, const vm::machine_argume
          {
             tm.stop();
             size_t ms = tm.milliseconds();
+            const size_t cpu_ms(get_cpu_time() - start_cpu);
             
             cout << "Time: " << ms << " ms" << endl;
+            // idle threads that sleep show up as CPU time below wall time * threads
+            cout << "CPU time: " << cpu_ms << " ms";
+            if(ms > 0)
+               cout << " (" << (100 * cpu_ms) / (ms * num_threads) << "% of " << num_threads << " threads)";
+            cout << endl;
          }
       }
 
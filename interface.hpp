@@ -11,6 +11,13 @@ extern bool show_database;
 extern bool dump_database;
 extern bool time_execution;
 extern bool memory_statistics;
+extern bool numa_mode;
+extern bool predecoded_mode;
+extern bool full_aggregates_mode;
+extern bool compact_mode;
+extern size_t bucket_width;
+extern size_t node_quota;
+extern bool latency_statistics;
 
 void parse_sched(char *);
 void help_schedulers(void);
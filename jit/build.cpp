@@ -47,6 +47,22 @@ field_type_to_jit_type(const field_type typ)
    return jit_type_int;
 }
 
+// type of the field inside the tuple, booleans only take one byte
+static jit_type_t
+field_type_to_storage_type(const field_type typ)
+{
+   if(typ == FIELD_BOOL)
+      return jit_type_ubyte;
+   return field_type_to_jit_type(typ);
+}
+
+// fields are placed by predicate::build_field_info, with or without COMPACT_TUPLES
+static inline jit_nint
+field_offset(const predicate *pred, const field_num field)
+{
+   return (jit_nint)predicate::get_layout(pred->get_id())[field].offset;
+}
+
 #if 0
 static void
 print_tuple(vm::tuple *tpl)
@@ -160,9 +176,8 @@ compile_instruction(const pcounter pc, state& state, jit_function_t *f, reg_map&
          assert(it_pred != preds.end());
          const predicate *pred(it_pred->second);
 
-         jit_value_t args(jit_insn_add_relative(*f, reg_val, jit_type_get_size(tuple_type)));
-         jit_value_t idx(jit_value_create_nint_constant(*f, jit_type_int, (int)from));
-         jit_value_t arg(jit_insn_load_elem(*f, args, idx, reg_type));
+         jit_value_t arg(jit_insn_load_relative(*f, reg_val, field_offset(pred, from),
+                  field_type_to_storage_type(pred->get_field_type(from)->get_type())));
          reg_map::iterator it2(regs.find(to));
 
          jit_value_t toval;
@@ -224,19 +239,17 @@ compile_instruction(const pcounter pc, state& state, jit_function_t *f, reg_map&
          reg_map::iterator it(regs.find(tuple_reg));
          assert(it != regs.end());
          jit_value_t tuple_val(it->second.val);
-#if 0
-         pred_map::iterator it_pred(preds.find(reg));
+         pred_map::iterator it_pred(preds.find(tuple_reg));
          assert(it_pred != preds.end());
          const predicate *pred(it_pred->second);
-#endif
 
          reg_map::iterator it2(regs.find(reg));
          assert(it2 != regs.end());
          jit_value_t reg_val(it2->second.val);
 
-         jit_value_t args(jit_insn_add_relative(*f, tuple_val, jit_type_get_size(tuple_type)));
-         jit_value_t arg(jit_insn_add_relative(*f, args, field * jit_type_get_size(reg_type)));
-         jit_insn_store_relative(*f, arg, 0, reg_val);
+         jit_value_t arg(jit_insn_convert(*f, reg_val,
+                  field_type_to_storage_type(pred->get_field_type(field)->get_type()), 0));
+         jit_insn_store_relative(*f, tuple_val, field_offset(pred, field), arg);
          break;
       }
       case INTGREATER_INSTR: {
@@ -317,10 +330,13 @@ compile_bytecode(byte_code code, const size_t len, vm::state& state)
       jit_type_t intrusive_list_type_fields[] = {jit_type_void_ptr, jit_type_void_ptr};
       intrusive_list_type = jit_type_create_struct(intrusive_list_type_fields, sizeof(intrusive_list_type_fields)/sizeof(jit_type_t), 0);
 
-      // create tuple type
-      jit_type_t tuple_type_fields[] = {jit_type_void_ptr, jit_type_void_ptr, jit_type_ubyte, jit_type_void_ptr};
+      // create type for the tuple header (list pointers, flags and predicate id)
+      jit_type_t tuple_type_fields[] = {jit_type_void_ptr, jit_type_void_ptr, jit_type_ubyte, jit_type_ubyte};
       tuple_type = jit_type_create_struct(tuple_type_fields, sizeof(tuple_type_fields)/sizeof(jit_type_t), 0);
       assert(jit_type_get_size(jit_type_ubyte) == sizeof(utils::byte));
+      assert(jit_type_get_size(jit_type_ubyte) == sizeof(predicate_id));
+      assert(jit_type_get_size(jit_type_ubyte) == sizeof(bool_val));
+      assert(jit_type_get_offset(tuple_type, 3) + sizeof(predicate_id) == TUPLE_FIELDS_START);
       assert(jit_type_get_size(tuple_type) == sizeof(vm::tuple));
 
    jit_context_build_start(ctx);
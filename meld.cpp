@@ -29,6 +29,13 @@ help(void)
 	help_schedulers();
 	cerr << "\t-t \t\ttime execution" << endl;
 	cerr << "\t-m \t\tmemory statistics" << endl;
+	cerr << "\t-n \t\tNUMA mode (pin threads and use socket-local memory)" << endl;
+	cerr << "\t-X \t\tuse the pre-decoded interpreter" << endl;
+	cerr << "\t-a \t\trecompute aggregates from all values (validation)" << endl;
+	cerr << "\t-k \t\tcompact the linear facts of each node" << endl;
+	cerr << "\t-w <width>\tbucket width for integer priorities (thpX)" << endl;
+	cerr << "\t-q <rules>\trules a node runs before letting other nodes run" << endl;
+	cerr << "\t-l \t\tnode latency statistics" << endl;
 	cerr << "\t-i <file>\tdump time statistics" << endl;
 	cerr << "\t-s \t\tshows database" << endl;
    cerr << "\t-d \t\tdump database (debug option)" << endl;
@@ -88,6 +95,45 @@ read_arguments(int argc, char **argv)
          case 'm':
             memory_statistics = true;
             break;
+         case 'n':
+            numa_mode = true;
+            break;
+         case 'X':
+            predecoded_mode = true;
+            break;
+         case 'a':
+            full_aggregates_mode = true;
+            break;
+         case 'k':
+            compact_mode = true;
+            break;
+         case 'w': {
+            if(argc < 2)
+               help();
+
+            const int width(atoi(argv[1]));
+            if(width <= 0)
+               help();
+            bucket_width = (size_t)width;
+            argc--;
+            argv++;
+         }
+         break;
+         case 'q': {
+            if(argc < 2)
+               help();
+
+            const int quota(atoi(argv[1]));
+            if(quota < 0)
+               help();
+            node_quota = (size_t)quota;
+            argc--;
+            argv++;
+         }
+         break;
+         case 'l':
+            latency_statistics = true;
+            break;
          case 'i':
             if(argc < 2)
                help();
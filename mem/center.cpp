@@ -33,6 +33,28 @@ center::allocate(size_t cnt, size_t sz)
    return p;
 }
 
+void*
+center::allocate_contiguous(size_t cnt, size_t sz)
+{
+   void *p;
+
+   register_allocation(cnt, sz);
+
+   if(USE_ALLOCATOR)
+      p = get_pool()->allocate_contiguous(cnt * sz);
+   else
+      p = ::operator new(cnt * sz);
+
+#ifdef ALLOCATOR_ASSERT
+   allocator_mtx.lock();
+   assert(mem_set.find(p) == mem_set.end());
+   mem_set.insert(p);
+   allocator_mtx.unlock();
+#endif
+
+   return p;
+}
+
 void
 center::deallocate(void *p, size_t cnt, size_t sz)
 {
@@ -14,6 +14,8 @@ class center
 public:
 
    static void* allocate(size_t cnt, size_t sz);
+   // objects allocated one after the other are placed next to each other
+   static void* allocate_contiguous(size_t cnt, size_t sz);
    static void deallocate(void *p, size_t cnt, size_t sz);
 };
 
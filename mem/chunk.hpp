@@ -2,59 +2,77 @@
 #ifndef MEM_CHUNK_HPP
 #define MEM_CHUNK_HPP
 
+#include <cstdlib>
+#include <new>
+#include <stdint.h>
+
 #include "mem/stat.hpp"
+#include "utils/numa.hpp"
 
 namespace mem
 {
-   
-class chunkgroup;
 
+// memory is handed to the size classes in slabs of SLAB_SIZE bytes.
+// slabs are aligned to their size, so the slab of any object
+// can be found by masking its address
+static const size_t SLAB_SIZE = 64 * 1024;
+static const size_t SLABS_PER_CHUNK = 16;
+
+// big block of memory that is split into slabs
 class chunk
 {
 private:
-   
-   friend class chunkgroup;
-   
+
+   friend class pool;
+
    chunk *next_chunk;
-   
+
+   unsigned char *mem;
+   size_t total;
    unsigned char *cur;
-   unsigned char *bottom;
    unsigned char *top;
-   
+   const int socket;
+
 public:
-   
-   inline void set_next(chunk *ptr)
-   {
-      next_chunk = ptr;
-   }
-   
-   inline void* allocate(const size_t size)
-   {
-      unsigned char *old_cur(cur);
 
-      cur += size;
-      
-      if(cur > top)
+   inline void* allocate_slab(void)
+   {
+      if(cur == top)
          return NULL; // full
-      
+
+      unsigned char *old_cur(cur);
+      cur += SLAB_SIZE;
       return old_cur;
    }
-   
-   explicit chunk(const size_t size, const size_t num_elems):
-      next_chunk(NULL)
+
+   explicit chunk(chunk *next, const int _socket = -1):
+      next_chunk(next), socket(_socket)
    {
-      const size_t total(size * num_elems);
-      
-      bottom = new unsigned char[total];
-      cur = bottom;
-      top = bottom + total;
-      
+      if(socket >= 0) {
+         // memory from the NUMA library is only page aligned
+         total = (SLABS_PER_CHUNK + 1) * SLAB_SIZE;
+         mem = (unsigned char*)utils::numa_allocate(total, socket);
+         if(mem == NULL)
+            throw std::bad_alloc();
+         cur = (unsigned char*)(((uintptr_t)mem + SLAB_SIZE - 1) & ~(uintptr_t)(SLAB_SIZE - 1));
+      } else {
+         void *ptr;
+         total = SLABS_PER_CHUNK * SLAB_SIZE;
+         if(posix_memalign(&ptr, SLAB_SIZE, total) != 0)
+            throw std::bad_alloc();
+         mem = cur = (unsigned char*)ptr;
+      }
+      top = cur + SLABS_PER_CHUNK * SLAB_SIZE;
+
       register_malloc();
    }
-   
+
    ~chunk(void)
    {
-      delete []bottom;
+      if(socket >= 0)
+         utils::numa_deallocate(mem, total);
+      else
+         free(mem);
    }
 };
 
@@ -2,91 +2,138 @@
 #ifndef MEM_CHUNKGROUP_HPP
 #define MEM_CHUNKGROUP_HPP
 
-#include <limits>
+#include <assert.h>
 
 #include "mem/chunk.hpp"
 
 namespace mem
 {
 
+// a free object, freed objects returned by other
+// threads are linked in batches using next_batch
+struct mem_node {
+   struct mem_node *next;
+   struct mem_node *next_batch;
+};
+
+class chunkgroup;
+
+// the first bytes of each slab point to the size class that owns it
+static const size_t SLAB_HEADER_SIZE = 64;
+
+struct slab_header {
+   chunkgroup *group;
+};
+
+static inline chunkgroup*
+slab_group(void *ptr)
+{
+   return ((slab_header*)((uintptr_t)ptr & ~(uintptr_t)(SLAB_SIZE - 1)))->group;
+}
+
+// all the objects of a size class for a given thread
 class chunkgroup
 {
 private:
 
-   struct mem_node {
-      struct mem_node *next;
-   };
-
    const size_t size;
-   chunk *first_chunk;
-   chunk *new_chunk; // chunk with readily usable objects
-   mem_node *free_objs; // list of freed objects
-   
-   static const size_t INITIAL_NUM_ELEMS = 64;
-   size_t num_elems_per_chunk;
+   unsigned char *cur; // readily usable objects of the last slab
+   unsigned char *top;
+   mem_node *free_objs; // list of freed objects (thread magazine)
+   mem_node * volatile returned; // batches freed by other threads
+
+   inline void reclaim(void)
+   {
+      mem_node *batch((mem_node*)__sync_lock_test_and_set(&returned, (mem_node*)NULL));
+
+      while(batch) {
+         mem_node *next_batch(batch->next_batch);
+         mem_node *tail(batch);
+
+         while(tail->next)
+            tail = tail->next;
+         tail->next = free_objs;
+         free_objs = batch;
+         batch = next_batch;
+      }
+   }
 
 public:
-   
+
+   inline size_t get_size(void) const { return size; }
+
+   // returns NULL if a new slab is needed
    inline void* allocate(void)
    {
       void *ret;
-      
+
+      if(free_objs == NULL && returned != NULL)
+         reclaim();
+
       if(free_objs != NULL) {
          // use a free chunk node
          ret = free_objs;
          free_objs = free_objs->next;
          return ret;
       }
-      
-      if(new_chunk == NULL) {
-         // this is the first chunk
-         new_chunk = first_chunk = new chunk(size, num_elems_per_chunk);
-         return new_chunk->allocate(size);
+
+      if((size_t)(top - cur) >= size) {
+         ret = cur;
+         cur += size;
+         return ret;
       }
 
-      ret = new_chunk->allocate(size);
-
-      if(ret == NULL) { // chunk full!
-         chunk *old_chunk(new_chunk);
-         if(num_elems_per_chunk < std::numeric_limits<std::size_t>::max()/2)
-            num_elems_per_chunk *= 2; // increase number of elements
-         new_chunk = new chunk(size, num_elems_per_chunk);
-         old_chunk->set_next(new_chunk);
-         return new_chunk->allocate(size);
-      } else {
-         // use returned chunk
+      return NULL;
+   }
+
+   // only takes objects from the end of the last slab, so that
+   // consecutive calls return adjacent objects (NULL if a new slab is needed)
+   inline void* allocate_fresh(void)
+   {
+      if((size_t)(top - cur) >= size) {
+         void *ret(cur);
+         cur += size;
          return ret;
       }
+
+      return NULL;
+   }
+
+   inline void add_slab(void *slab)
+   {
+      ((slab_header*)slab)->group = this;
+      cur = (unsigned char*)slab + SLAB_HEADER_SIZE;
+      top = (unsigned char*)slab + SLAB_SIZE;
    }
-   
+
+   // owner thread only
    inline void deallocate(void* ptr)
    {
       mem_node *new_node((mem_node*)ptr);
-      
+
       new_node->next = free_objs;
       free_objs = new_node;
    }
-   
-   explicit chunkgroup(const size_t _size):
-      size(_size), first_chunk(NULL),
-      new_chunk(NULL), free_objs(NULL),
-      num_elems_per_chunk(INITIAL_NUM_ELEMS)
+
+   // any thread, gives back a NULL terminated list of objects
+   inline void deallocate_batch_other(mem_node *batch)
    {
+      while(true) {
+         mem_node *old(returned);
+         batch->next_batch = old;
+         if(__sync_bool_compare_and_swap(&returned, old, batch))
+            return;
+      }
    }
-   
-   ~chunkgroup(void)
+
+   explicit chunkgroup(const size_t _size):
+      size(_size), cur(NULL), top(NULL),
+      free_objs(NULL), returned(NULL)
    {
-      chunk *cur(first_chunk);
-      
-      while (cur) {
-         chunk *next(cur->next_chunk);
-         delete cur;
-         cur = next;
-      }
+      assert(size >= sizeof(mem_node));
    }
 };
 
 }
 
 #endif
-
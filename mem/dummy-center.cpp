@@ -16,6 +16,11 @@ center::allocate(size_t cnt, size_t sz)
 {
 }
 
+void*
+center::allocate_contiguous(size_t cnt, size_t sz)
+{
+}
+
 void
 center::deallocate(void *p, size_t cnt, size_t sz)
 {
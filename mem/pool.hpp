@@ -6,7 +6,6 @@
 #include <iostream>
 #include <assert.h>
 #include <cstdio>
-#include <tr1/unordered_map>
 
 #include "mem/chunkgroup.hpp"
 
@@ -16,54 +15,190 @@ namespace mem
 class pool
 {
 private:
-   
-   static const size_t ATOM_SIZE = 4;
-   
-   typedef std::tr1::unordered_map<size_t, chunkgroup*> chunk_map;
-
-   chunk_map chunks;
-   
-   chunkgroup *get_group(const size_t size)
+
+   // objects are grouped in size classes of CLASS_GRANULARITY bytes,
+   // bigger objects are given to the system allocator
+   static const size_t CLASS_SHIFT = 3;
+   static const size_t CLASS_GRANULARITY = 1 << CLASS_SHIFT;
+   static const size_t MAX_CLASS_SIZE = 1024;
+   static const size_t NUM_CLASSES = (MAX_CLASS_SIZE >> CLASS_SHIFT) + 1;
+
+   // objects of other threads are given back after this many frees
+   static const size_t REMOTE_BATCH_SIZE = 64;
+
+   typedef struct {
+      chunkgroup *target;
+      mem_node *head;
+      size_t count;
+   } remote_batch;
+
+   chunkgroup *groups[NUM_CLASSES];
+   remote_batch remote[NUM_CLASSES];
+   // objects of other threads held in the batches
+   size_t remote_pending;
+   chunk *chunks;
+   int socket;
+
+   static inline size_t size_class(const size_t size)
    {
-      assert(size > 0);
-        
-      chunk_map::iterator it(chunks.find(size));
-      chunkgroup *grp;
-      
-      if(it == chunks.end()) {
-         grp = new chunkgroup(size);
-         chunks[size] = grp;
-      } else
-         grp = it->second;
-         
-      assert(grp != NULL);
-      
+      if(size < sizeof(mem_node))
+         return sizeof(mem_node) >> CLASS_SHIFT;
+      return (size + CLASS_GRANULARITY - 1) >> CLASS_SHIFT;
+   }
+
+   inline chunkgroup *get_group(const size_t cls)
+   {
+      chunkgroup *grp(groups[cls]);
+
+      if(grp == NULL) {
+         grp = new chunkgroup(cls << CLASS_SHIFT);
+         groups[cls] = grp;
+      }
+
       return grp;
    }
 
+   inline void *new_slab(void)
+   {
+      void *slab(chunks ? chunks->allocate_slab() : NULL);
+
+      if(slab == NULL) {
+         chunks = new chunk(chunks, socket);
+         slab = chunks->allocate_slab();
+      }
+
+      return slab;
+   }
+
+   inline void flush_remote(remote_batch& batch)
+   {
+      if(batch.head == NULL)
+         return;
+
+      batch.target->deallocate_batch_other(batch.head);
+      remote_pending -= batch.count;
+      batch.head = NULL;
+      batch.count = 0;
+   }
+
+   // object allocated by another thread, it is given back to its
+   // owner once we have a full batch of objects from the same owner
+   inline void deallocate_remote(const size_t cls, chunkgroup *target, void *ptr)
+   {
+      remote_batch& batch(remote[cls]);
+      mem_node *node((mem_node*)ptr);
+
+      if(batch.target != target) {
+         flush_remote(batch);
+         batch.target = target;
+      }
+
+      node->next = batch.head;
+      batch.head = node;
+      ++remote_pending;
+
+      if(++batch.count == REMOTE_BATCH_SIZE)
+         flush_remote(batch);
+   }
+
 public:
-   
+
    inline void* allocate(const size_t size)
    {
-      return get_group(size)->allocate();
+      assert(size > 0);
+
+      if(size > MAX_CLASS_SIZE)
+         return ::operator new(size);
+
+      chunkgroup *grp(get_group(size_class(size)));
+      void *ret(grp->allocate());
+
+      if(ret == NULL) {
+         grp->add_slab(new_slab());
+         ret = grp->allocate();
+      }
+
+      assert(ret != NULL);
+
+      return ret;
+   }
+
+   // like allocate, but without reusing freed objects
+   inline void* allocate_contiguous(const size_t size)
+   {
+      assert(size > 0);
+
+      if(size > MAX_CLASS_SIZE)
+         return ::operator new(size);
+
+      chunkgroup *grp(get_group(size_class(size)));
+      void *ret(grp->allocate_fresh());
+
+      if(ret == NULL) {
+         grp->add_slab(new_slab());
+         ret = grp->allocate_fresh();
+      }
+
+      assert(ret != NULL);
+
+      return ret;
    }
-   
+
    inline void deallocate(void *ptr, const size_t size)
    {
-      return get_group(size)->deallocate(ptr);
+      if(size > MAX_CLASS_SIZE) {
+         ::operator delete(ptr);
+         return;
+      }
+
+      const size_t cls(size_class(size));
+      chunkgroup *owner(slab_group(ptr));
+
+      assert(owner->get_size() == (cls << CLASS_SHIFT));
+
+      if(owner == groups[cls])
+         owner->deallocate(ptr);
+      else
+         deallocate_remote(cls, owner, ptr);
    }
-   
-   explicit pool(void)
+
+   // gives back the objects of other threads that wait for a full batch,
+   // must be called before the thread stops freeing objects for a while
+   inline void flush_remote_batches(void)
+   {
+      for(size_t i(0); remote_pending > 0 && i < NUM_CLASSES; ++i)
+         flush_remote(remote[i]);
+   }
+
+   // allocate new chunks on the given socket
+   inline void set_socket(const int _socket)
    {
+      socket = _socket;
    }
-   
+
+   inline int get_socket(void) const { return socket; }
+
+   explicit pool(const int _socket = -1):
+      remote_pending(0), chunks(NULL), socket(_socket)
+   {
+      for(size_t i(0); i < NUM_CLASSES; ++i) {
+         groups[i] = NULL;
+         remote[i].target = NULL;
+         remote[i].head = NULL;
+         remote[i].count = 0;
+      }
+   }
+
    ~pool(void)
    {
-      for(chunk_map::iterator it(chunks.begin());
-         it != chunks.end();
-         ++it)
-      {
-         delete it->second;
+      flush_remote_batches();
+      for(size_t i(0); i < NUM_CLASSES; ++i)
+         delete groups[i];
+
+      while(chunks) {
+         chunk *next(chunks->next_chunk);
+         delete chunks;
+         chunks = next;
       }
    }
 };
@@ -1,27 +1,27 @@
 
-#include "utils/atomic.hpp"
 #include "mem/stat.hpp"
 
-using namespace utils;
-
 namespace mem
 {
    
 #ifdef MEMORY_STATISTICS
 
-static atomic<size_t> memory_in_use(0);
-static atomic<size_t> num_mallocs(0);
+// updated by the database loaders and by all the threads, so the counters
+// are statically initialized and only changed with atomic instructions
+static volatile size_t memory_in_use = 0;
+static volatile size_t num_mallocs = 0;
+static volatile size_t num_avoided = 0;
 
 void
 register_allocation(const size_t cnt, const size_t size)
 {
-   memory_in_use += cnt * size;
+   __sync_fetch_and_add(&memory_in_use, cnt * size);
 }
 
 void
 register_deallocation(const size_t cnt, const size_t size)
 {
-   memory_in_use -= cnt * size;
+   __sync_fetch_and_sub(&memory_in_use, cnt * size);
 }
 
 size_t
@@ -33,7 +33,7 @@ get_memory_in_use(void)
 void
 register_malloc(void)
 {
-   num_mallocs++;
+   __sync_fetch_and_add(&num_mallocs, 1);
 }
 
 size_t
@@ -42,6 +42,18 @@ get_num_mallocs(void)
    return num_mallocs;
 }
 
+void
+register_avoided_allocation(void)
+{
+   __sync_fetch_and_add(&num_avoided, 1);
+}
+
+size_t
+get_num_avoided_allocations(void)
+{
+   return num_avoided;
+}
+
 #endif
    
 }
\ No newline at end of file
@@ -18,11 +18,17 @@ void register_malloc(void);
 
 size_t get_num_mallocs(void);
 
+// a fact moved to a node of the same thread without a simple_tuple
+void register_avoided_allocation(void);
+
+size_t get_num_avoided_allocations(void);
+
 #else
 
 #define register_allocation(CNT, SIZE) /* do nothing */
 #define register_deallocation(CNT, SIZE) /* do nothing */
 #define register_malloc() /* do nothing */
+#define register_avoided_allocation() /* do nothing */
 
 #endif
 
@@ -1,5 +1,6 @@
 
 #include <iostream>
+#include <vector>
 #include <tr1/unordered_set>
 
 #include "mem/thread.hpp"
@@ -20,6 +21,10 @@ static bool init(void);
 
 static pthread_key_t pool_key;
 static bool started(init());
+// pools of threads that are done, the objects allocated from them are still
+// in use, so they are given to new threads instead of being deleted
+static vector<pool*> released_pools;
+static boost::mutex released_mtx;
 
 static void
 cleanup_memsystem(void)
@@ -55,10 +60,44 @@ delete_pool(void)
 }
 
 void
-ensure_pool(void)
+ensure_pool(const int socket)
 {
-   if(NULL == get_pool())
-      create_pool();
+   if(pthread_getspecific(pool_key) != NULL)
+      return;
+
+   pool *pl(NULL);
+
+   {
+      boost::mutex::scoped_lock l(released_mtx);
+
+      for(vector<pool*>::iterator it(released_pools.begin()), end(released_pools.end()); it != end; ++it) {
+         if((*it)->get_socket() == socket) {
+            pl = *it;
+            released_pools.erase(it);
+            break;
+         }
+      }
+   }
+
+   if(pl == NULL)
+      pl = new pool(socket);
+
+   pthread_setspecific(pool_key, pl);
+}
+
+void
+release_pool(void)
+{
+   pool *pl((pool*)pthread_getspecific(pool_key));
+
+   if(pl == NULL)
+      return;
+
+   pthread_setspecific(pool_key, NULL);
+   pl->flush_remote_batches();
+
+   boost::mutex::scoped_lock l(released_mtx);
+   released_pools.push_back(pl);
 }
 
 pool*
@@ -14,9 +14,15 @@ namespace mem
 pool *get_pool(void);
    
 void create_pool(void);
-void ensure_pool(void);
+// gives the current thread a pool with chunks on the given socket (-1 for any),
+// reusing a pool released by another thread if there is one
+void ensure_pool(const int socket = -1);
 void delete_pool(void);
 
+// the current thread stops using its pool, which keeps the objects allocated
+// from it and is given to the next thread that calls ensure_pool
+void release_pool(void);
+
 void cleanup(const size_t);
   
 }
@@ -6,10 +6,13 @@
 #include "vm/program.hpp"
 #include "vm/state.hpp"
 #include "vm/exec.hpp"
+#include "db/agg_configuration.hpp"
 #include "mem/thread.hpp"
 #include "mem/stat.hpp"
 #include "stat/stat.hpp"
 #include "utils/fs.hpp"
+#include "utils/numa.hpp"
+#include "utils/time.hpp"
 #include "interface.hpp"
 #include "sched/serial.hpp"
 #include "sched/serial_ui.hpp"
@@ -17,6 +20,8 @@
 #include "thread/threads.hpp"
 #include "runtime/objs.hpp"
 #include "thread/prio.hpp"
+#include "thread/mq.hpp"
+#include "thread/bucket.hpp"
 
 using namespace process;
 using namespace db;
@@ -247,12 +252,25 @@ machine::start(void)
          all->DATABASE->dump_db(cout);
    }
 
+#ifdef OPCODE_PROFILING
+   vm::opcode_profile::dump(filename);
+#endif
+
    if(memory_statistics) {
 #ifdef MEMORY_STATISTICS
       cout << "Total memory in use: " << get_memory_in_use() / 1024 << "KB" << endl;
       cout << "Malloc()'s called: " << get_num_mallocs() << endl;
+      cout << "Allocations avoided by local sends: " << get_num_avoided_allocations() << endl;
 #else
       cout << "Memory statistics support was not compiled in" << endl;
+#endif
+   }
+
+   if(latency_statistics) {
+#ifdef NODE_LATENCY_STATISTICS
+      vm::print_latency_statistics(cout);
+#else
+      cout << "Node latency statistics support was not compiled in" << endl;
 #endif
    }
 }
@@ -265,6 +283,8 @@ get_creation_function(const scheduler_type sched_type)
          return database::create_node_fn(sched::threads_sched::create_node);
       case SCHED_THREADS_PRIO:
          return database::create_node_fn(sched::threads_prio::create_node);
+      case SCHED_THREADS_MQ:
+         return database::create_node_fn(sched::threads_mq::create_node);
 #if 0
       case SCHED_THREADS_DYNAMIC_LOCAL:
          return database::create_node_fn(sched::dynamic_local::create_node);
@@ -307,6 +327,9 @@ machine::machine(const string& file, router& _rout, const size_t th,
    bool added_data_file(false);
 
    All = all;
+   execution_time load_time;
+   if(time_execution)
+      load_time.start();
    this->all->PROGRAM = new vm::program(file);
    theProgram = this->all->PROGRAM;
    if(this->all->PROGRAM->is_data())
@@ -323,25 +346,77 @@ machine::machine(const string& file, router& _rout, const size_t th,
       }
    }
 
+   if(sched_type == SCHED_THREADS_MQ && this->all->PROGRAM->get_priority_type() != FIELD_FLOAT)
+      throw machine_error(string("the mqX scheduler only supports float priorities"));
+
+   if(time_execution) {
+      load_time.stop();
+      cout << "Load program: " << load_time << endl;
+   }
+
    this->all->ROUTER = &_rout;
 
    if(margs.size() < this->all->PROGRAM->num_args_needed())
       throw machine_error(string("this program requires ") + utils::to_string(all->PROGRAM->num_args_needed()) + " arguments");
 
    this->all->set_arguments(margs);
-   this->all->DATABASE = new database(added_data_file ? data_file : filename, get_creation_function(_sched_type));
+
+   if(numa_mode && !is_serial_sched(sched_type)) {
+      if(!numa_init(th))
+         cerr << "NUMA support was not compiled in or is not available" << endl;
+   }
+
+   if(full_aggregates_mode)
+      db::agg_configuration::INCREMENTAL = false;
+   vm::state::COMPACT = compact_mode;
+   vm::state::QUOTA = node_quota;
+
+   // the database is loaded by up to NUM_THREADS threads
    this->all->NUM_THREADS = th;
+   execution_time db_time;
+   if(time_execution)
+      db_time.start();
+   this->all->DATABASE = new database(added_data_file ? data_file : filename, get_creation_function(_sched_type));
+   if(time_execution) {
+      db_time.stop();
+      cout << "Load database: " << db_time << endl;
+   }
    this->all->MACHINE = this;
 #ifdef USE_REAL_NODES
+   execution_time fix_time;
+   if(time_execution)
+      fix_time.start();
    this->all->PROGRAM->fix_node_addresses(this->all->DATABASE);
+   if(time_execution) {
+      fix_time.stop();
+      cout << "Fix node addresses: " << fix_time << endl;
+   }
 #endif
 
+   if(predecoded_mode) {
+      execution_time decode_time;
+      if(time_execution)
+         decode_time.start();
+      this->all->PROGRAM->decode_bytecode();
+      vm::state::PREDECODED = true;
+      if(time_execution) {
+         decode_time.stop();
+         cout << "Decode bytecode: " << decode_time << endl;
+      }
+   }
+
    switch(sched_type) {
       case SCHED_THREADS:
          sched::threads_sched::start(all->NUM_THREADS);
          break;
       case SCHED_THREADS_PRIO:
-         sched::threads_prio::start(all->NUM_THREADS);
+         if(theProgram->get_priority_type() == FIELD_INT)
+            sched::threads_bucket::start(all->NUM_THREADS);
+         else
+            sched::threads_prio::start(all->NUM_THREADS);
+         break;
+      case SCHED_THREADS_MQ:
+         sched::threads_mq::start(all->NUM_THREADS);
          break;
 #if 0
       case SCHED_THREADS_SINGLE_LOCAL:
@@ -0,0 +1,217 @@
+
+#ifndef QUEUE_BUCKET_PQUEUE_HPP
+#define QUEUE_BUCKET_PQUEUE_HPP
+
+#include <vector>
+#include <stdint.h>
+
+#include "mem/allocator.hpp"
+#include "utils/spinlock.hpp"
+#include "utils/atomic.hpp"
+
+namespace queue
+{
+
+// buckets kept at once (a power of two), keys further apart share buckets
+#define BUCKET_PQUEUE_SLOTS 4096
+// key of the objects that are not in the queue
+#define BUCKET_NOT_QUEUED INT64_MIN
+
+// concurrent bucketed priority queue (delta-stepping) where smaller keys go first.
+// all the threads take objects from the bucket of the current key and move to the
+// next key when it is empty. inserting and changing the key of an object is O(1):
+// a new entry is added and the old one is dropped when found, since it no longer
+// matches the key of the object. T needs a 'volatile int64_t bucket_key' field
+// initialized to BUCKET_NOT_QUEUED
+template <class T>
+class intrusive_bucket_pqueue
+{
+private:
+
+   typedef struct {
+      T *obj;
+      int64_t key;
+   } entry;
+
+   typedef std::vector<entry, mem::allocator<entry> > entry_vector;
+
+   typedef struct {
+      utils::spinlock mtx;
+      entry_vector entries;
+   } bucket;
+
+   bucket *slots;
+   volatile int64_t current;
+   utils::atomic<size_t> total;
+
+   static inline size_t slot_of(const int64_t key) { return (size_t)key & (BUCKET_PQUEUE_SLOTS - 1); }
+
+   static inline void remove_entry(bucket& b, const size_t i)
+   {
+      b.entries[i] = b.entries.back();
+      b.entries.pop_back();
+   }
+
+   inline void lower_current(const int64_t key)
+   {
+      int64_t cur(current);
+
+      while(key < cur) {
+         if(__sync_bool_compare_and_swap(&current, cur, key))
+            return;
+         cur = current;
+      }
+   }
+
+   inline void add_entry(T *obj, const int64_t key)
+   {
+      bucket& b(slots[slot_of(key)]);
+      const entry e = {obj, key};
+
+      {
+         utils::spinlock::scoped_lock l(b.mtx);
+         b.entries.push_back(e);
+      }
+
+      lower_current(key);
+   }
+
+   // takes an object with the given key from its bucket
+   T *take(const int64_t key)
+   {
+      bucket& b(slots[slot_of(key)]);
+      utils::spinlock::scoped_lock l(b.mtx);
+
+      for(size_t i(b.entries.size()); i > 0; --i) {
+         const entry e(b.entries[i - 1]);
+
+         if(e.obj->bucket_key != e.key) {
+            // the key has changed
+            remove_entry(b, i - 1);
+            continue;
+         }
+
+         if(e.key != key)
+            continue; // further ahead, shares the bucket
+
+         remove_entry(b, i - 1);
+         if(__sync_bool_compare_and_swap(&e.obj->bucket_key, key, (int64_t)BUCKET_NOT_QUEUED)) {
+            total--;
+            return e.obj;
+         }
+      }
+
+      return NULL;
+   }
+
+   // smallest key in the queue
+   bool find_min(int64_t& min)
+   {
+      bool found(false);
+
+      for(size_t i(0); i < BUCKET_PQUEUE_SLOTS; ++i) {
+         bucket& b(slots[i]);
+         utils::spinlock::scoped_lock l(b.mtx);
+
+         for(typename entry_vector::const_iterator it(b.entries.begin()), end(b.entries.end()); it != end; ++it) {
+            if(it->obj->bucket_key == it->key && (!found || it->key < min)) {
+               min = it->key;
+               found = true;
+            }
+         }
+      }
+
+      return found;
+   }
+
+public:
+
+   inline bool empty(void) const { return total == 0; }
+   inline size_t size(void) const { return total; }
+   inline int64_t current_key(void) const { return current; }
+
+   static inline bool in_queue(const T *obj) { return obj->bucket_key != BUCKET_NOT_QUEUED; }
+
+   // obj must not be in the queue
+   void insert(T *obj, const int64_t key)
+   {
+      assert(!in_queue(obj));
+
+      obj->bucket_key = key;
+      total++;
+      add_entry(obj, key);
+   }
+
+   // moves obj to a new key if it is still in the queue
+   bool update(T *obj, const int64_t key)
+   {
+      while(true) {
+         const int64_t old(obj->bucket_key);
+
+         if(old == BUCKET_NOT_QUEUED)
+            return false;
+         if(old == key)
+            return true;
+         if(__sync_bool_compare_and_swap(&obj->bucket_key, old, key))
+            break;
+      }
+
+      add_entry(obj, key);
+      return true;
+   }
+
+   // removes obj if it is still in the queue
+   bool remove(T *obj)
+   {
+      while(true) {
+         const int64_t old(obj->bucket_key);
+
+         if(old == BUCKET_NOT_QUEUED)
+            return false;
+         if(__sync_bool_compare_and_swap(&obj->bucket_key, old, (int64_t)BUCKET_NOT_QUEUED)) {
+            total--;
+            return true;
+         }
+      }
+   }
+
+   T *pop(void)
+   {
+      while(!empty()) {
+         for(size_t step(0); step < BUCKET_PQUEUE_SLOTS && !empty(); ++step) {
+            const int64_t key(current);
+            T *obj(take(key));
+
+            if(obj)
+               return obj;
+
+            // bucket is empty, move to the next one
+            __sync_bool_compare_and_swap(&current, key, key + 1);
+         }
+
+         // the next key is far ahead or a key behind the current one was missed
+         int64_t min(0);
+         if(!find_min(min))
+            return NULL;
+         current = min;
+      }
+
+      return NULL;
+   }
+
+   explicit intrusive_bucket_pqueue(void):
+      slots(new bucket[BUCKET_PQUEUE_SLOTS]),
+      current(0),
+      total(0)
+   {
+   }
+
+   ~intrusive_bucket_pqueue(void)
+   {
+      delete []slots;
+   }
+};
+
+}
+
+#endif
@@ -10,6 +10,13 @@ public:  											\
    TYPE *__intrusive_prev;   					\
    bool __intrusive_in_queue
 
+// the steal state is odd while the node is queued and
+// is incremented each time the node enters or leaves a queue
+#define DECLARE_STEAL_QUEUE_NODE(TYPE)    \
+public:                                   \
+   TYPE *__intrusive_next;                \
+   volatile size_t __intrusive_steal_state
+
 #define DEFINE_PRIORITY_NODE(TYPE)				\
 public:													\
 	bool __intrusive_in_priority_queue;			\
@@ -24,11 +31,15 @@ public:													\
 #define INIT_DOUBLE_QUEUE_NODE()		\
 	__intrusive_next(NULL), __intrusive_prev(NULL), __intrusive_in_queue(false)
 
+#define INIT_STEAL_QUEUE_NODE()		\
+	__intrusive_next(NULL), __intrusive_steal_state(0)
+
 #define __INTRUSIVE_NEXT(ITEM) ((ITEM)->__intrusive_next)
 #define __INTRUSIVE_PREV(ITEM) ((ITEM)->__intrusive_prev)
 #define __INTRUSIVE_IN_QUEUE(ITEM) ((ITEM)->__intrusive_in_queue)
 #define __INTRUSIVE_IN_PRIORITY_QUEUE(ITEM) ((ITEM->__intrusive_in_priority_queue))
 #define __INTRUSIVE_PRIORITY(ITEM) ((ITEM)->__intrusive_priority)
 #define __INTRUSIVE_POS(ITEM) ((ITEM)->__intrusive_pos)
+#define __INTRUSIVE_STEAL_STATE(ITEM) ((ITEM)->__intrusive_steal_state)
 
 #endif
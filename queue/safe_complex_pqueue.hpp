@@ -89,6 +89,12 @@ private:
 		}
 	}
 
+	inline bool contains(heap_object node) const
+	{
+		const int pos(__INTRUSIVE_POS(node));
+		return __INTRUSIVE_IN_PRIORITY_QUEUE(node) && pos < (int)heap.size() && heap[pos] == node;
+	}
+
 public:
 	
 	HEAP_DEFINE_EMPTY;
@@ -158,6 +164,37 @@ public:
 		do_insert(node, new_prio);
 	}
 
+	// priority of the first node, false if the queue is empty
+	bool top_priority(heap_priority& pr) const
+	{
+      utils::spinlock::scoped_lock l(mtx);
+      if(empty())
+         return false;
+      pr = __INTRUSIVE_PRIORITY(heap.front());
+      return true;
+	}
+
+	// changes the priority of the node if it is in this queue
+	bool update(heap_object node, const heap_priority new_prio)
+	{
+      utils::spinlock::scoped_lock l(mtx);
+      if(!contains(node))
+         return false;
+		do_remove(node);
+		do_insert(node, new_prio);
+      return true;
+	}
+
+	// removes the node if it is in this queue
+	bool remove_if_present(heap_object node)
+	{
+      utils::spinlock::scoped_lock l(mtx);
+      if(!contains(node))
+         return false;
+		do_remove(node);
+      return true;
+	}
+
 	void set_type(const heap_type _typ)
 	{
 		typ = _typ;
@@ -22,9 +22,10 @@ private:
       queue_item(const T _item, const P _prio): item(_item), priority(_prio) {}
    };
 
+   // the item with the lowest priority is at the top
    struct queue_item_comparator {
       bool operator() (const queue_item& a, const queue_item& b) {
-         return a.priority < b.priority;
+         return a.priority > b.priority;
       }
    };
 
@@ -0,0 +1,295 @@
+
+#ifndef QUEUE_WORK_STEALING_DEQUE_HPP
+#define QUEUE_WORK_STEALING_DEQUE_HPP
+
+#include <vector>
+#include <algorithm>
+
+#include "conf.hpp"
+#include "queue/intrusive.hpp"
+
+namespace queue
+{
+
+// lock-free work stealing deque (Chase-Lev) for intrusive nodes
+// - the owner thread uses push() at the bottom of the deque
+// - the owner pop() and the other threads steal() from the top, so nodes
+//   are run in FIFO order (with LIFO some programs that pass tokens between
+//   nodes, like mfp, starve the nodes at the top of the deque)
+// - other threads may add nodes with push_other(), these are kept in a
+//   lock-free stack and moved into the deque by the owner thread
+//
+// each entry remembers the steal state of the node when it was pushed.
+// remove() changes the state but leaves the entry in the deque, so
+// pop() and steal() must claim the node with a CAS on the state and
+// discard entries that are out of date.
+template <class T>
+class intrusive_work_stealing_deque
+{
+private:
+
+   typedef T* node_type;
+   typedef long index_type;
+
+   typedef struct {
+      node_type node;
+      size_t state;
+   } entry;
+
+   class circular_array
+   {
+   private:
+
+      const index_type mask;
+      entry *data;
+
+   public:
+
+      inline index_type capacity(void) const { return mask + 1; }
+
+      inline entry get(const index_type i) const { return data[i & mask]; }
+      inline void put(const index_type i, const entry& e) { data[i & mask] = e; }
+
+      inline circular_array *grow(const index_type bottom, const index_type top) const
+      {
+         circular_array *bigger(new circular_array(capacity() * 2));
+         for(index_type i(top); i < bottom; ++i)
+            bigger->put(i, get(i));
+         return bigger;
+      }
+
+      explicit circular_array(const index_type size):
+         mask(size - 1), data(new entry[size])
+      {
+         assert((size & mask) == 0);
+      }
+
+      ~circular_array(void) { delete []data; }
+   };
+
+   static const index_type INITIAL_CAPACITY = 1024;
+
+   volatile index_type top;
+   volatile index_type bottom;
+   circular_array * volatile array;
+
+   // arrays replaced by grow() are kept alive because thieves may
+   // still be reading from them, they are freed in the destructor
+   std::vector<circular_array*> old_arrays;
+
+   // nodes added by other threads
+   volatile node_type incoming;
+
+   static inline bool claim(const entry& e)
+   {
+      return __sync_bool_compare_and_swap(&__INTRUSIVE_STEAL_STATE(e.node), e.state, e.state + 1);
+   }
+
+   static inline void mark_queued(node_type node)
+   {
+      assert(!in_queue(node));
+      __INTRUSIVE_STEAL_STATE(node)++;
+   }
+
+   inline void push_bottom(node_type node)
+   {
+      const index_type b(bottom);
+      const index_type t(top);
+      circular_array *a(array);
+      entry e;
+
+      e.node = node;
+      e.state = __INTRUSIVE_STEAL_STATE(node);
+
+      if(b - t >= a->capacity() - 1) {
+         old_arrays.push_back(a);
+         a = a->grow(b, t);
+         array = a;
+      }
+
+      a->put(b, e);
+      __asm__ __volatile__("" : : : "memory");
+      bottom = b + 1;
+   }
+
+   inline bool steal_top(entry& e)
+   {
+      while(true) {
+         const index_type t(top);
+         __asm__ __volatile__("" : : : "memory");
+         const index_type b(bottom);
+
+         if(t >= b)
+            return false;
+
+         circular_array *a(array);
+         e = a->get(t);
+
+         if(__sync_bool_compare_and_swap(&top, t, t + 1))
+            return true;
+      }
+   }
+
+   // move nodes added by other threads into the deque (in arrival order)
+   inline void flush_incoming(void)
+   {
+      node_type list((node_type)__sync_lock_test_and_set(&incoming, (node_type)NULL));
+      node_type reversed(NULL);
+
+      while(list) {
+         node_type next(__INTRUSIVE_NEXT(list));
+         __INTRUSIVE_NEXT(list) = reversed;
+         reversed = list;
+         list = next;
+      }
+
+      while(reversed) {
+         node_type next(__INTRUSIVE_NEXT(reversed));
+         __INTRUSIVE_NEXT(reversed) = NULL;
+         push_bottom(reversed);
+         reversed = next;
+      }
+   }
+
+public:
+
+   // number of entries in the deque. this is only an upper bound of the
+   // queued nodes, since removed nodes keep their entries until they are
+   // discarded and nodes added by other threads are not counted yet
+   inline size_t size(void) const
+   {
+      const index_type sz(bottom - top);
+      return sz > 0 ? (size_t)sz : 0;
+   }
+
+   inline bool empty(void) const { return bottom <= top && incoming == NULL; }
+
+   static inline bool in_queue(node_type node)
+   {
+      return __INTRUSIVE_STEAL_STATE(node) & 1;
+   }
+
+   // owner thread only
+   inline void push(node_type node)
+   {
+      mark_queued(node);
+      push_bottom(node);
+   }
+
+   // any thread except the owner
+   inline void push_other(node_type node)
+   {
+      mark_queued(node);
+
+      while(true) {
+         node_type old(incoming);
+         __INTRUSIVE_NEXT(node) = old;
+         if(__sync_bool_compare_and_swap(&incoming, old, node))
+            return;
+      }
+   }
+
+   // owner thread only
+   inline bool pop(node_type& node)
+   {
+      entry e;
+
+      if(incoming != NULL)
+         flush_incoming();
+
+      while(steal_top(e)) {
+         if(claim(e)) {
+            node = e.node;
+            return true;
+         }
+      }
+
+      return false;
+   }
+
+   // any thread
+   inline bool steal(node_type& node)
+   {
+      entry e;
+
+      while(steal_top(e)) {
+         if(claim(e)) {
+            node = e.node;
+            return true;
+         }
+      }
+
+      return false;
+   }
+
+   // any thread, takes half of the entries (at most max) from the top with
+   // a single CAS and returns the number of nodes put into nodes.
+   // entries that are out of date are dropped
+   inline size_t steal_batch(node_type *nodes, const size_t max)
+   {
+      assert(max > 0);
+      entry taken[max];
+
+      while(true) {
+         const index_type t(top);
+         __asm__ __volatile__("" : : : "memory");
+         const index_type b(bottom);
+
+         if(t >= b)
+            return 0;
+
+         const index_type n(std::min(std::max((b - t) / 2, (index_type)1), (index_type)max));
+         circular_array *a(array);
+
+         for(index_type i(0); i < n; ++i)
+            taken[i] = a->get(t + i);
+
+         if(!__sync_bool_compare_and_swap(&top, t, t + n))
+            continue;
+
+         size_t claimed(0);
+
+         for(index_type i(0); i < n; ++i) {
+            if(claim(taken[i]))
+               nodes[claimed++] = taken[i].node;
+         }
+
+         if(claimed > 0)
+            return claimed;
+      }
+   }
+
+   // owner thread only, the entry stays in the deque
+   // and is discarded once it is popped or stolen
+   inline bool remove(node_type node)
+   {
+      if(incoming != NULL)
+         flush_incoming();
+
+      const size_t state(__INTRUSIVE_STEAL_STATE(node));
+
+      if(!(state & 1))
+         return false;
+
+      return __sync_bool_compare_and_swap(&__INTRUSIVE_STEAL_STATE(node), state, state + 1);
+   }
+
+   explicit intrusive_work_stealing_deque(void):
+      top(0), bottom(0),
+      array(new circular_array(INITIAL_CAPACITY)),
+      incoming(NULL)
+   {
+   }
+
+   ~intrusive_work_stealing_deque(void)
+   {
+      assert(incoming == NULL);
+      delete array;
+      for(size_t i(0); i < old_arrays.size(); ++i)
+         delete old_arrays[i];
+   }
+};
+
+}
+
+#endif
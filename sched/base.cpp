@@ -6,6 +6,7 @@
 #include "db/tuple.hpp"
 #include "vm/exec.hpp"
 #include "process/machine.hpp"
+#include "utils/numa.hpp"
 
 using namespace std;
 using namespace boost;
@@ -77,7 +78,15 @@ base::do_loop(void)
 void
 base::loop(void)
 {
-   // start process pool
+   if(utils::numa_enabled()) {
+      // pin the thread before the pool allocates anything else. the pool
+      // of the database loader of this socket is reused if it is free
+      utils::numa_pin_thread(id);
+      mem::ensure_pool(utils::numa_thread_socket(id));
+      mem::get_pool()->set_socket(utils::numa_thread_socket(id));
+   }
+
+   // start process pool (possibly the pool of a database loader)
    mem::ensure_pool();
 
    init(All->NUM_THREADS);
@@ -87,7 +87,7 @@ public:
       vm::tuple *init_tuple(vm::tuple::create(init_pred));
       node->set_owner(this);
       node->add_linear_fact(init_tuple, init_pred);
-      node->unprocessed_facts = true;
+      node->mark_unprocessed();
    }
    
    // a new aggregate is to be inserted into the work queue
@@ -99,6 +99,12 @@ public:
    
    // work to be sent to the same thread
    virtual void new_work(db::node *, db::node *, vm::tuple*, vm::predicate *, const vm::ref_count, const vm::depth_t) = 0;
+   // work for a node run by this scheduler that is not running, which takes the
+   // tuple without going through new_work. returns false if new_work must be used
+   virtual bool take_local_work(db::node *, vm::tuple*, vm::predicate *, const vm::ref_count, const vm::depth_t)
+   {
+      return false;
+   }
    // delayed work to be sent to the target thread
    virtual void new_work_delay(db::node *, db::node *, vm::tuple*, vm::predicate *, const vm::ref_count, const vm::depth_t, const vm::uint_val)
    {
@@ -138,6 +144,10 @@ public:
    
    inline size_t num_iterations(void) const { return iteration; }
 
+#ifdef NODE_LATENCY_STATISTICS
+   inline const vm::latency_histogram& get_latencies(void) const { return state.latencies; }
+#endif
+
 	inline void join(void) { thread->join(); }
 	
 	void start(void);
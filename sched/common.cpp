@@ -21,11 +21,11 @@ assert_static_nodes_end_iteration(const process_id id)
 
    const node::node_id first(remote::self->find_first_node(id));
    const node::node_id final(remote::self->find_last_node(id));
-   database::map_nodes::iterator it(All->DATABASE->get_node_iterator(first));
-   database::map_nodes::iterator end(All->DATABASE->get_node_iterator(final));
+   database::iterator it(All->DATABASE->get_node_iterator(first));
+   database::iterator end(All->DATABASE->get_node_iterator(final));
 
    for(; it != end; ++it)
-      it->second->assert_end_iteration();
+      (*it)->assert_end_iteration();
 }
 
 void
@@ -36,11 +36,11 @@ assert_static_nodes_end(const process_id id)
 
    const node::node_id first(remote::self->find_first_node(id));
    const node::node_id final(remote::self->find_last_node(id));
-   database::map_nodes::iterator it(All->DATABASE->get_node_iterator(first));
-   database::map_nodes::iterator end(All->DATABASE->get_node_iterator(final));
+   database::iterator it(All->DATABASE->get_node_iterator(first));
+   database::iterator end(All->DATABASE->get_node_iterator(final));
 
    for(; it != end; ++it)
-      it->second->assert_end();
+      (*it)->assert_end();
 }
 #endif
 
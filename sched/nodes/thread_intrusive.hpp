@@ -10,6 +10,7 @@
 #include "sched/base.hpp"
 #include "process/work.hpp"
 #include "queue/safe_simple_pqueue.hpp"
+#include "queue/bucket_pqueue.hpp"
 #include "vm/state.hpp"
 
 namespace sched
@@ -17,7 +18,7 @@ namespace sched
 
 class thread_intrusive_node: public thread_node
 {
-	DECLARE_DOUBLE_QUEUE_NODE(thread_intrusive_node);
+	DECLARE_STEAL_QUEUE_NODE(thread_intrusive_node);
 	DEFINE_PRIORITY_NODE(thread_intrusive_node);
 	
 private:
@@ -44,13 +45,20 @@ public:
       }
    }
 
+	// queue of the relaxed priority scheduler where the node was last inserted
+	size_t relaxed_queue;
+	// key in the bucket queue of the integer priority scheduler
+	volatile int64_t bucket_key;
+
 	// xxx to remove
 	bool has_been_prioritized;
    bool has_been_touched;
 
    explicit thread_intrusive_node(const db::node::node_id _id, const db::node::node_id _trans):
 		thread_node(_id, _trans),
-      INIT_DOUBLE_QUEUE_NODE(), INIT_PRIORITY_NODE(),
+      INIT_STEAL_QUEUE_NODE(), INIT_PRIORITY_NODE(),
+      relaxed_queue(0),
+      bucket_key(BUCKET_NOT_QUEUED),
 		has_been_prioritized(false),
       has_been_touched(false)
    {
@@ -33,6 +33,22 @@ serial_local::new_work(node *from, node *target, vm::tuple *tpl, vm::predicate *
    }
 }
    
+bool
+serial_local::take_local_work(node *target, vm::tuple *tpl, vm::predicate *pred, const ref_count count, const depth_t depth)
+{
+   serial_node *to((serial_node*)target);
+
+   if(!to->add_local_fact(tpl, pred, count, depth))
+      return false;
+
+   if(!to->in_queue()) {
+      to->set_in_queue(true);
+      queue_nodes.push(to);
+   }
+
+   return true;
+}
+   
 void
 serial_local::assert_end(void) const
 {
@@ -58,6 +74,12 @@ serial_local::get_work(void)
             return NULL;
 			if(!queue_nodes.pop(current_node))
 				return NULL;
+      } else if(current_node->yielded && has_work()) {
+         // the node ran out of its quota, run the other nodes first
+         current_node->yielded = false;
+         queue_nodes.push(current_node);
+			if(!queue_nodes.pop(current_node))
+				return NULL;
       }
    } else {
       if(!has_work())
@@ -91,12 +113,12 @@ serial_local::generate_aggs(void)
 void
 serial_local::init(const size_t)
 {
-   database::map_nodes::iterator it(All->DATABASE->get_node_iterator(remote::self->find_first_node(id)));
-   database::map_nodes::iterator end(All->DATABASE->get_node_iterator(remote::self->find_last_node(id)));
+   database::iterator it(All->DATABASE->get_node_iterator(remote::self->find_first_node(id)));
+   database::iterator end(All->DATABASE->get_node_iterator(remote::self->find_last_node(id)));
    
    for(; it != end; ++it)
    {
-      serial_node *cur_node(dynamic_cast<serial_node*>(it->second));
+      serial_node *cur_node(dynamic_cast<serial_node*>(*it));
       
       init_node(cur_node);
       cur_node->set_in_queue(true);
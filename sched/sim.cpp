@@ -76,8 +76,8 @@ sim_sched::init(const size_t num_threads)
 		
 	assert(num_threads == 1);
 	
-   database::map_nodes::iterator it(state.all->DATABASE->get_node_iterator(remote::self->find_first_node(id)));
-   database::map_nodes::iterator end(state.all->DATABASE->get_node_iterator(remote::self->find_last_node(id)));
+   database::iterator it(state.all->DATABASE->get_node_iterator(remote::self->find_first_node(id)));
+   database::iterator end(state.all->DATABASE->get_node_iterator(remote::self->find_last_node(id)));
 
 	// no nodes
 	assert(it == end);
@@ -262,12 +262,12 @@ sim_sched::instantiate_all_nodes(void)
    assert(!all_instantiated);
    assert(thread_mode);
 
-   for(database::map_nodes::const_iterator it(state.all->DATABASE->nodes_begin()),
+   for(database::iterator it(state.all->DATABASE->nodes_begin()),
          end(state.all->DATABASE->nodes_end());
          it != end;
          ++it)
    {
-      node *n(it->second);
+      node *n(*it);
       sim_node *no((sim_node *)n);
 
       no->set_instantiated(true);
@@ -2,54 +2,129 @@
 #ifndef SCHED_THREAD_TERMINATION_BARRIER_HPP
 #define SCHED_THREAD_TERMINATION_BARRIER_HPP
 
-#include "vm/state.hpp"
+#include <assert.h>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+
 #include "utils/atomic.hpp"
 #include "utils/macros.hpp"
 
 namespace sched
 {
-   
+
+// threads that share a counter of active threads
+#define TERMINATION_GROUP_SIZE 8
+#define TERMINATION_CACHE_LINE 64
+
+// counts the active threads in two levels: each group of threads has its own
+// counter and the root only counts the groups with active threads. a thread
+// only touches the counter of its group, unless the group becomes idle or
+// stops being idle, so that short idle periods do not contend on a single
+// cache line shared by all the threads
 class termination_barrier
 {
 private:
-   
-   utils::atomic<size_t> active_threads;
-   const size_t num_threads;
-   
+
+   struct group_counter {
+      utils::atomic<size_t> active;
+      char pad[TERMINATION_CACHE_LINE - sizeof(utils::atomic<size_t>)];
+   } __attribute__((aligned(TERMINATION_CACHE_LINE)));
+
+   // the counters of the groups followed by the counter of the groups with
+   // active threads, each one in its own cache line
+   group_counter *counters;
+   // group of each thread
+   std::vector<size_t> groups;
+   size_t num_groups;
+
    volatile bool done;
-   
+
+   inline group_counter& group_of(const size_t id) { return counters[groups[id]]; }
+   inline utils::atomic<size_t>& active_groups(void) { return counters[num_groups].active; }
+
+   void init_counters(void)
+   {
+      void *mem(NULL);
+
+      num_groups = groups.empty() ? 0 : *std::max_element(groups.begin(), groups.end()) + 1;
+      if(posix_memalign(&mem, TERMINATION_CACHE_LINE, sizeof(group_counter) * (num_groups + 1)) != 0)
+         abort();
+      counters = (group_counter*)mem;
+
+      // all the threads start active
+      for(size_t i(0); i < num_groups; ++i)
+         counters[i].active = 0;
+      for(size_t i(0); i < groups.size(); ++i)
+         counters[groups[i]].active++;
+      active_groups() = num_groups;
+   }
+
 public:
-   
+
    inline void reset(void) { done = false; }
    inline void set_done(void) { done = true; }
-   
-   inline void is_active(void)
+
+   inline void is_active(const size_t id)
    {
-      assert(active_threads < num_threads);
-      active_threads++;
+      group_counter& g(group_of(id));
+
+      assert(g.active < groups.size());
+      if(g.active++ == 0)
+         active_groups()++;
    }
-   
-   inline void is_inactive(void)
+
+   inline void is_inactive(const size_t id)
    {
-      assert(active_threads > 0);
-      if(--active_threads == 0)
-         done = true;
+      group_counter& g(group_of(id));
+
+      assert(g.active > 0);
+      if(--g.active == 0) {
+         assert(active_groups() > 0);
+         if(--active_groups() == 0)
+            done = true;
+      }
+   }
+
+   // not exact while threads are changing state
+   inline size_t num_active(void) const
+   {
+      size_t ret(0);
+
+      for(size_t i(0); i < num_groups; ++i)
+         ret += counters[i].active;
+
+      return ret;
    }
-   
-   inline size_t num_active(void) const { return active_threads; }
-   
+
    inline bool all_finished(void) const { return done; }
-   
-   // we use this for MPI, because in MPI the counter can reach zero and 
+
+   // we use this for MPI, because in MPI the counter can reach zero and
    // and become positive since we can get new work from remote threads
-   inline bool zero_active_threads(void) const { return active_threads == 0; }
-   
-   explicit termination_barrier(const size_t _num_threads):
-      active_threads(_num_threads), num_threads(_num_threads), done(false)
+   inline bool zero_active_threads(void) const { return counters[num_groups].active == 0; }
+
+   // consecutive threads form groups of _group_size threads
+   explicit termination_barrier(const size_t num_threads, const size_t _group_size = TERMINATION_GROUP_SIZE):
+      groups(num_threads), done(false)
+   {
+      const size_t group_size(std::max(_group_size, (size_t)1));
+
+      for(size_t i(0); i < num_threads; ++i)
+         groups[i] = i / group_size;
+      init_counters();
+   }
+
+   // _groups[i] is the group of thread i, groups are numbered from 0
+   explicit termination_barrier(const std::vector<size_t>& _groups):
+      groups(_groups), done(false)
+   {
+      init_counters();
+   }
+
+   ~termination_barrier(void)
    {
+      free(counters);
    }
-   
-   ~termination_barrier(void) {}
 };
 
 }
@@ -1,5 +1,6 @@
 
 #include "sched/thread/threaded.hpp"
+#include "utils/numa.hpp"
 
 using namespace boost;
 using namespace std;
@@ -12,12 +13,21 @@ tree_barrier* threaded::thread_barrier(NULL);
 termination_barrier* threaded::term_barrier(NULL);
 atomic<size_t> threaded::total_in_agg(0);
 volatile size_t threaded::round_state(1);
+utils::atomic<size_t> threaded::parked_threads(0);
 
 void
 threaded::init_barriers(const size_t num_threads)
 {
    thread_barrier = new tree_barrier(num_threads);
-   term_barrier = new termination_barrier(num_threads);
+   if(numa_enabled()) {
+      // threads of the same socket share a counter. sockets get contiguous
+      // blocks of threads, which may have different sizes
+      vector<size_t> groups(num_threads, 0);
+      for(size_t i(1); i < num_threads; ++i)
+         groups[i] = groups[i - 1] + (numa_same_socket(i - 1, i) ? 0 : 1);
+      term_barrier = new termination_barrier(groups);
+   } else
+      term_barrier = new termination_barrier(num_threads);
    total_in_agg = num_threads;
 }
    
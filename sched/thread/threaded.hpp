@@ -15,6 +15,7 @@
 #include "sched/thread/termination_barrier.hpp"
 #include "sched/thread/state.hpp"
 #include "utils/tree_barrier.hpp"
+#include "utils/idle.hpp"
 
 namespace sched
 {
@@ -24,6 +25,7 @@ class threaded
 private:
      
    volatile thread_state tstate;
+   const vm::process_id thread_id;
    
 protected:
    
@@ -31,6 +33,10 @@ protected:
    static utils::tree_barrier *thread_barrier;
    
 	utils::spinlock lock;
+   // used to sleep while the thread has nothing to do
+   utils::idle_waiter idle;
+   // number of threads sleeping in idle
+   static utils::atomic<size_t> parked_threads;
 	
    static volatile size_t round_state;
    size_t thread_round_state;
@@ -50,14 +56,14 @@ protected:
    {
       assert(tstate == THREAD_INACTIVE);
       tstate = THREAD_ACTIVE;
-      term_barrier->is_active();
+      term_barrier->is_active(thread_id);
    }
    
    inline void set_inactive(void)
    {
       assert(tstate == THREAD_ACTIVE);
       tstate = THREAD_INACTIVE;
-      term_barrier->is_inactive();
+      term_barrier->is_inactive(thread_id);
    }
    
    inline void set_active_if_inactive(void)
@@ -83,7 +89,8 @@ protected:
    
 public:
    
-   explicit threaded(void): tstate(THREAD_ACTIVE),
+   explicit threaded(const vm::process_id _id): tstate(THREAD_ACTIVE),
+      thread_id(_id),
       thread_round_state(1)
    {
    }
@@ -124,7 +131,8 @@ public:
       spinlock::scoped_lock l(OTHER->lock);              \
       if((OTHER)->is_inactive() && (OTHER)->has_work())  \
          (OTHER)->set_active();                          \
-   }
+   }                                                     \
+   (OTHER)->idle.wake();
    
 }
 
@@ -140,8 +148,10 @@ public:
    assert(total_in_agg > 0);                             \
    total_in_agg--;                                       \
    assert_thread_iteration(iteration);                   \
+   utils::backoff bo;                                    \
    if(leader_thread()) {                                 \
-      while(total_in_agg != 0) {}                        \
+      while(total_in_agg != 0)                           \
+         bo.wait();                                      \
       bool more_work(false);                             \
       COMPUTE_MORE_WORK                                  \
       if(more_work) {                                    \
@@ -156,7 +166,8 @@ public:
       }                                                  \
    } else {                                              \
       const size_t supos(GET_NEXT(thread_round_state));  \
-      while(round_state == thread_round_state) {}        \
+      while(round_state == thread_round_state)           \
+         bo.wait();                                      \
       if(round_state == supos) {                         \
          thread_round_state = supos;                     \
          assert(thread_round_state == round_state);      \
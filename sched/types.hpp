@@ -11,6 +11,7 @@ enum scheduler_type {
    SCHED_UNKNOWN,
    SCHED_THREADS,
    SCHED_THREADS_PRIO,
+   SCHED_THREADS_MQ,
    SCHED_SERIAL,
 	SCHED_SERIAL_UI
 #ifdef USE_SIM
@@ -34,12 +35,12 @@ inline bool is_mpi_sched(const scheduler_type)
 
 inline bool is_work_stealing_sched(const scheduler_type type)
 {
-   return type == SCHED_THREADS || type == SCHED_THREADS_PRIO;
+   return type == SCHED_THREADS || type == SCHED_THREADS_PRIO || type == SCHED_THREADS_MQ;
 }
 
 inline bool is_priority_sched(const scheduler_type type)
 {
-   return type == SCHED_THREADS_PRIO;
+   return type == SCHED_THREADS_PRIO || type == SCHED_THREADS_MQ;
 }
 
 }
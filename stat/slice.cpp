@@ -54,6 +54,18 @@ slice::print_stolen_nodes(csv_line& csv) const
    csv << to_string<size_t>(stolen_nodes);
 }
 
+void
+slice::print_steal_attempts(csv_line& csv) const
+{
+   csv << to_string<size_t>(steal_attempts);
+}
+
+void
+slice::print_steal_batches(csv_line& csv) const
+{
+   csv << to_string<size_t>(steal_batches);
+}
+
 void
 slice::print_sent_facts_same_thread(csv_line& csv) const
 {
@@ -72,4 +84,28 @@ slice::print_sent_facts_other_thread_now(csv_line& csv) const
    csv << to_string<size_t>(sent_facts_other_thread_now);
 }
 
+void
+slice::print_sent_batches(csv_line& csv) const
+{
+   csv << to_string<size_t>(sent_batches);
+}
+
+void
+slice::print_batch_size(csv_line& csv) const
+{
+   csv << to_string<size_t>(batch_size);
+}
+
+void
+slice::print_priority_pops(csv_line& csv) const
+{
+   csv << to_string<size_t>(priority_pops);
+}
+
+void
+slice::print_rank_error(csv_line& csv) const
+{
+   csv << to_string<double>(rank_error);
+}
+
 }
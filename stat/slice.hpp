@@ -20,18 +20,30 @@ public:
    size_t consumed_facts;
    size_t rules_run;
    size_t stolen_nodes;
+   size_t steal_attempts;
+   size_t steal_batches;
    size_t sent_facts_same_thread;
    size_t sent_facts_other_thread;
    size_t sent_facts_other_thread_now;
+   size_t sent_batches;
+   size_t batch_size;
+   size_t priority_pops;
+   double rank_error;
    
    void print_state(utils::csv_line&) const;
    void print_derived_facts(utils::csv_line&) const;
    void print_consumed_facts(utils::csv_line&) const;
    void print_rules_run(utils::csv_line&) const;
    void print_stolen_nodes(utils::csv_line&) const;
+   void print_steal_attempts(utils::csv_line&) const;
+   void print_steal_batches(utils::csv_line&) const;
    void print_sent_facts_same_thread(utils::csv_line&) const;
    void print_sent_facts_other_thread(utils::csv_line&) const;
    void print_sent_facts_other_thread_now(utils::csv_line&) const;
+   void print_sent_batches(utils::csv_line&) const;
+   void print_batch_size(utils::csv_line&) const;
+   void print_priority_pops(utils::csv_line&) const;
+   void print_rank_error(utils::csv_line&) const;
    
    explicit slice(void):
       state(NOW_IDLE),
@@ -40,9 +52,15 @@ public:
       consumed_facts(0),
       rules_run(0),
       stolen_nodes(0),
+      steal_attempts(0),
+      steal_batches(0),
       sent_facts_same_thread(0),
       sent_facts_other_thread(0),
-      sent_facts_other_thread_now(0)
+      sent_facts_other_thread_now(0),
+      sent_batches(0),
+      batch_size(0),
+      priority_pops(0),
+      rank_error(0.0)
    {
    }
    
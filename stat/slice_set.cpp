@@ -91,6 +91,18 @@ slice_set::write_stolen_nodes(const string& file, vm::all *all) const
    write_general(file + ".stolen_nodes", "stolennodes", &slice::print_stolen_nodes, all);
 }
 
+void
+slice_set::write_steal_attempts(const string& file, vm::all *all) const
+{
+   write_general(file + ".steal_attempts", "stealattempts", &slice::print_steal_attempts, all);
+}
+
+void
+slice_set::write_steal_batches(const string& file, vm::all *all) const
+{
+   write_general(file + ".steal_batches", "stealbatches", &slice::print_steal_batches, all);
+}
+
 void
 slice_set::write_sent_facts_same_thread(const string& file, vm::all *all) const
 {
@@ -109,18 +121,49 @@ slice_set::write_sent_facts_other_thread_now(const string& file, vm::all *all) c
    write_general(file + ".sent_facts_other_thread_now", "sentfactsotherthreadnow", &slice::print_sent_facts_other_thread_now, all);
 }
 
+void
+slice_set::write_sent_batches(const string& file, vm::all *all) const
+{
+   write_general(file + ".sent_batches", "sentbatches", &slice::print_sent_batches, all);
+}
+
+void
+slice_set::write_batch_size(const string& file, vm::all *all) const
+{
+   write_general(file + ".batch_size", "batchsize", &slice::print_batch_size, all);
+}
+
+void
+slice_set::write_priority_pops(const string& file, vm::all *all) const
+{
+   write_general(file + ".priority_pops", "prioritypops", &slice::print_priority_pops, all);
+}
+
+void
+slice_set::write_rank_error(const string& file, vm::all *all) const
+{
+   write_general(file + ".rank_error", "rankerror", &slice::print_rank_error, all);
+}
+
 void
 slice_set::write(const string& file, const scheduler_type type, vm::all *all) const
 {
-   (void)type;
    write_state(file, all);
    write_derived_facts(file, all);
    write_consumed_facts(file, all);
    write_rules_run(file, all);
    write_stolen_nodes(file, all);
+   write_steal_attempts(file, all);
+   write_steal_batches(file, all);
    write_sent_facts_same_thread(file, all);
    write_sent_facts_other_thread(file, all);
    write_sent_facts_other_thread_now(file, all);
+   write_sent_batches(file, all);
+   write_batch_size(file, all);
+   if(type == SCHED_THREADS_MQ) {
+      write_priority_pops(file, all);
+      write_rank_error(file, all);
+   }
 #if 0
    if(is_priority_sched(type))
       write_priority_queue(file, all);
@@ -36,9 +36,15 @@ private:
    void write_consumed_facts(const std::string&, vm::all *) const;
    void write_rules_run(const std::string&, vm::all *) const;
    void write_stolen_nodes(const std::string&, vm::all *) const;
+   void write_steal_attempts(const std::string&, vm::all *) const;
+   void write_steal_batches(const std::string&, vm::all *) const;
    void write_sent_facts_same_thread(const std::string&, vm::all *) const;
    void write_sent_facts_other_thread(const std::string&, vm::all *) const;
    void write_sent_facts_other_thread_now(const std::string&, vm::all *) const;
+   void write_sent_batches(const std::string&, vm::all *) const;
+   void write_batch_size(const std::string&, vm::all *) const;
+   void write_priority_pops(const std::string&, vm::all *) const;
+   void write_rank_error(const std::string&, vm::all *) const;
    
    typedef  void (slice::*print_fn)(utils::csv_line&) const;
    
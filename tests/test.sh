@@ -121,6 +121,12 @@ if [ "${TYPE}" = "sl" ]; then
 	exit 0
 fi
 
+if [ "${TYPE}" = "quota" ]; then
+	run_serial_n "sl -q 1" 1
+	run_serial_n "sl -q 3" 1
+	exit 0
+fi
+
 if [ "${TYPE}" = "tl" ]; then
 	loop_sched tl
 	exit 0
@@ -0,0 +1,237 @@
+#include <iostream>
+
+#include "thread/bucket.hpp"
+#include "db/database.hpp"
+#include "process/remote.hpp"
+#include "sched/thread/assert.hpp"
+#include "sched/common.hpp"
+#include "interface.hpp"
+
+using namespace std;
+using namespace process;
+using namespace vm;
+using namespace db;
+using namespace utils;
+
+namespace sched
+{
+
+threads_bucket::bucket_queue *threads_bucket::buckets(NULL);
+int_val threads_bucket::width(1);
+bool threads_bucket::descending(false);
+
+void
+threads_bucket::claim_node(thread_intrusive_node *node)
+{
+   // nodes taken from the buckets are run by this thread
+   node->lock();
+   node->set_owner(this);
+   node->unlock();
+}
+
+bool
+threads_bucket::check_if_current_useless(void)
+{
+   assert(current_node->in_queue());
+
+   current_node->lock();
+
+   if(!current_node->unprocessed_facts) {
+      current_node->set_in_queue(false);
+      current_node->set_int_priority_level(0);
+      current_node->unlock();
+      current_node = NULL;
+      return true;
+   }
+
+   if(current_node->has_priority_level() && !buckets->empty()
+         && buckets->current_key() < key_of(current_node->get_int_priority_level()))
+   {
+      // the threads moved to a better bucket, give this node back
+      push_bucket(current_node);
+      current_node->unlock();
+      current_node = NULL;
+      return true;
+   }
+
+   if(current_node->yielded && has_ready_nodes()) {
+      // the node ran out of its quota, run the other nodes first
+      current_node->yielded = false;
+      add_to_queue(current_node);
+      current_node->unlock();
+      current_node = NULL;
+      return true;
+   }
+
+   current_node->unlock();
+   return false;
+}
+
+bool
+threads_bucket::set_next_node(void)
+{
+   if(current_node != NULL)
+      check_if_current_useless();
+
+   while(current_node == NULL) {
+      if(!delay_queue.empty())
+         check_delayed_work();
+
+      if(!has_work()) {
+         if(!busy_wait())
+            return false;
+      }
+
+      current_node = buckets->pop();
+      if(current_node != NULL)
+         claim_node(current_node);
+      else if(!queue_nodes.pop(current_node))
+         continue;
+
+      assert(current_node != NULL);
+      assert(current_node->in_queue());
+
+      check_if_current_useless();
+   }
+
+   ins_active;
+
+   assert(current_node != NULL);
+
+   return true;
+}
+
+node*
+threads_bucket::get_work(void)
+{
+   if(!outbox.empty())
+      flush_outbox();
+
+   if(!set_next_node())
+      return NULL;
+
+   set_active_if_inactive();
+   assert(current_node != NULL);
+   assert(current_node->in_queue());
+   assert(current_node->unprocessed_facts);
+
+   return current_node;
+}
+
+void
+threads_bucket::do_set_node_priority(thread_intrusive_node *tn, const int_val priority)
+{
+   if(tn == current_node) {
+      tn->set_int_priority_level(priority);
+      return;
+   }
+
+   if(bucket_queue::in_queue(tn)) {
+      if(priority == 0) {
+         if(buckets->remove(tn)) {
+            tn->set_int_priority_level(0);
+            tn->set_owner(this);
+            queue_nodes.push(tn);
+            return;
+         }
+      } else if(key_of(priority) < key_of(tn->get_int_priority_level())) {
+         // decrease key
+         tn->set_int_priority_level(priority);
+         buckets->update(tn, key_of(priority));
+         return;
+      } else
+         return;
+   } else if(priority > 0 && tn->in_queue() && tn->get_owner() == this) {
+      // waiting in our normal queue
+      tn->set_int_priority_level(priority);
+      if(queue_nodes.remove(tn))
+         push_bucket(tn);
+      return;
+   }
+
+   // the node is running or idle, it will be queued with this priority
+   tn->set_int_priority_level(priority);
+}
+
+void
+threads_bucket::set_node_priority(node *n, const double priority)
+{
+   thread_intrusive_node *tn((thread_intrusive_node*)n);
+
+   tn->lock();
+   do_set_node_priority(tn, (int_val)priority);
+   tn->unlock();
+}
+
+void
+threads_bucket::add_node_priority(node *n, const double priority)
+{
+   thread_intrusive_node *tn((thread_intrusive_node*)n);
+
+   tn->lock();
+   do_set_node_priority(tn, tn->get_int_priority_level() + (int_val)priority);
+   tn->unlock();
+}
+
+void
+threads_bucket::schedule_next(node *n)
+{
+   static const int_val add = 100;
+   const int64_t current(buckets->current_key());
+
+   set_node_priority(n, (descending ? -current : current) * width + add);
+}
+
+void
+threads_bucket::init(const size_t)
+{
+   database::iterator it(All->DATABASE->get_node_iterator(remote::self->find_first_node(id)));
+   database::iterator end(All->DATABASE->get_node_iterator(remote::self->find_last_node(id)));
+   const heap_priority initial(theProgram->get_initial_priority());
+
+   for(; it != end; ++it)
+   {
+      thread_intrusive_node *cur_node((thread_intrusive_node*)*it);
+
+      init_node(cur_node);
+      cur_node->set_priority_level(initial);
+      cur_node->set_in_queue(true);
+      add_to_queue(cur_node);
+
+      assert(cur_node->get_owner() == this);
+      assert(cur_node->in_queue());
+      assert(cur_node->unprocessed_facts);
+   }
+
+   threads_synchronize();
+}
+
+void
+threads_bucket::start(const size_t num_threads)
+{
+   assert(theProgram->get_priority_type() == FIELD_INT);
+   assert(bucket_width > 0);
+
+   width = (int_val)bucket_width;
+   descending = theProgram->is_priority_desc();
+   buckets = new bucket_queue();
+
+   init_barriers(num_threads);
+   for(vm::process_id i(0); i < num_threads; ++i)
+      add_thread(new threads_bucket(i));
+}
+
+threads_bucket::threads_bucket(const vm::process_id _id):
+   threads_sched(_id)
+{
+}
+
+threads_bucket::~threads_bucket(void)
+{
+   if(get_id() == 0) {
+      delete buckets;
+      buckets = NULL;
+   }
+}
+
+}
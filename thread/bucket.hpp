@@ -0,0 +1,90 @@
+
+#ifndef THREAD_BUCKET_HPP
+#define THREAD_BUCKET_HPP
+
+#include "sched/base.hpp"
+#include "thread/threads.hpp"
+#include "queue/bucket_pqueue.hpp"
+#include "sched/nodes/thread_intrusive.hpp"
+#include "sched/thread/threaded.hpp"
+
+namespace sched
+{
+
+// priority scheduler for programs with integer priorities (delta-stepping).
+// prioritized nodes are kept in a bucket queue shared by all threads, where
+// each bucket holds the priorities of a range of 'width' values. the threads
+// run the nodes of the best bucket together before moving to the next one
+class threads_bucket: public threads_sched
+{
+protected:
+
+   typedef queue::intrusive_bucket_pqueue<thread_intrusive_node> bucket_queue;
+
+   static bucket_queue *buckets;
+   static vm::int_val width;
+   static bool descending;
+
+   // smaller keys are better
+   static inline int64_t key_of(const vm::int_val prio)
+   {
+      const int64_t key(prio / width);
+      return descending ? -key : key;
+   }
+
+   // node must be locked
+   inline void push_bucket(thread_intrusive_node *node)
+   {
+      buckets->insert(node, key_of(node->get_int_priority_level()));
+      if(parked_threads > 0)
+         wake_idle_thread();
+   }
+
+   void claim_node(thread_intrusive_node *);
+
+   virtual void add_to_queue(thread_intrusive_node *node)
+   {
+      if(node->has_priority_level())
+         push_bucket(node);
+      else
+         queue_nodes.push(node);
+   }
+
+   virtual void add_to_queue_other(thread_intrusive_node *node)
+   {
+      if(node->has_priority_level())
+         push_bucket(node);
+      else
+         queue_nodes.push_other(node);
+   }
+
+   virtual bool has_ready_nodes(void) const { return threads_sched::has_ready_nodes() || !buckets->empty(); }
+   virtual bool check_if_current_useless(void);
+   bool set_next_node(void);
+   void do_set_node_priority(thread_intrusive_node *, const vm::int_val);
+
+public:
+
+   virtual void init(const size_t);
+
+   virtual db::node* get_work(void);
+
+   virtual void set_node_priority(db::node *, const double);
+   virtual void add_node_priority(db::node *, const double);
+   virtual void schedule_next(db::node *);
+
+   static db::node *create_node(const db::node::node_id id, const db::node::node_id trans)
+   {
+      return new thread_intrusive_node(id, trans);
+   }
+
+   static void start(const size_t);
+
+   explicit threads_bucket(const vm::process_id);
+
+   virtual ~threads_bucket(void);
+};
+
+}
+
+#endif
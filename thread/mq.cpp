@@ -0,0 +1,350 @@
+#include <iostream>
+
+#include "thread/mq.hpp"
+#include "db/database.hpp"
+#include "process/remote.hpp"
+#include "sched/thread/assert.hpp"
+#include "sched/common.hpp"
+
+using namespace std;
+using namespace process;
+using namespace vm;
+using namespace db;
+using namespace utils;
+
+// random pairs of queues tried before looking at every queue
+#define MQ_POP_TRIES 2
+
+namespace sched
+{
+
+threads_mq::priority_queue *threads_mq::queues(NULL);
+size_t threads_mq::num_queues(0);
+heap_type threads_mq::priority_type(HEAP_FLOAT_ASC);
+utils::atomic<size_t> threads_mq::queued(0);
+
+void
+threads_mq::push_relaxed(thread_intrusive_node *node)
+{
+   const size_t q(rand(num_queues));
+
+   node->relaxed_queue = q;
+   queues[q].insert(node, node->get_priority_level());
+   queued++;
+
+   if(parked_threads > 0)
+      wake_idle_thread();
+}
+
+thread_intrusive_node*
+threads_mq::pop_relaxed(void)
+{
+   thread_intrusive_node *node(NULL);
+
+   if(queued == 0)
+      return NULL;
+
+   for(size_t i(0); i < MQ_POP_TRIES && node == NULL; ++i) {
+      const size_t q1(rand(num_queues));
+      const size_t q2(rand(num_queues));
+      heap_priority p1, p2;
+      const bool has1(queues[q1].top_priority(p1));
+      const bool has2(queues[q2].top_priority(p2));
+
+      if(!has1 && !has2)
+         continue;
+
+      if(has1 && (!has2 || !better(p2, p1)))
+         node = queues[q1].pop();
+      else
+         node = queues[q2].pop();
+   }
+
+   if(node == NULL) {
+      // only a few nodes are left
+      const size_t start(rand(num_queues));
+      for(size_t i(0); i < num_queues && node == NULL; ++i)
+         node = queues[(start + i) % num_queues].pop();
+      if(node == NULL)
+         return NULL;
+   }
+
+   queued--;
+#ifdef INSTRUMENTATION
+   priority_pops++;
+   rank_error += count_better_queues(node->get_priority_level());
+#endif
+   return node;
+}
+
+#ifdef INSTRUMENTATION
+size_t
+threads_mq::count_better_queues(const heap_priority pr) const
+{
+   size_t ret(0);
+
+   for(size_t i(0); i < num_queues; ++i) {
+      heap_priority top;
+      if(queues[i].top_priority(top) && better(top, pr))
+         ++ret;
+   }
+
+   return ret;
+}
+#endif
+
+bool
+threads_mq::sample_top(heap_priority& pr)
+{
+   return queues[rand(num_queues)].top_priority(pr);
+}
+
+void
+threads_mq::claim_node(thread_intrusive_node *node)
+{
+   // nodes taken from the shared queues are run by this thread
+   node->lock();
+   node->set_owner(this);
+   node->unlock();
+}
+
+bool
+threads_mq::check_if_current_useless(void)
+{
+   assert(current_node->in_queue());
+
+   current_node->lock();
+
+   if(!current_node->unprocessed_facts) {
+      current_node->set_in_queue(false);
+      current_node->set_float_priority_level(0.0);
+      current_node->unlock();
+      current_node = NULL;
+      return true;
+   }
+
+   heap_priority top;
+
+   if(current_node->has_priority_level() && sample_top(top)
+         && better(top, current_node->get_priority_level()))
+   {
+      // a better node is waiting, give this one back
+      push_relaxed(current_node);
+      current_node->unlock();
+      current_node = NULL;
+      return true;
+   }
+
+   if(current_node->yielded && has_ready_nodes()) {
+      // the node ran out of its quota, run the other nodes first
+      current_node->yielded = false;
+      add_to_queue(current_node);
+      current_node->unlock();
+      current_node = NULL;
+      return true;
+   }
+
+   current_node->unlock();
+   return false;
+}
+
+bool
+threads_mq::set_next_node(void)
+{
+   if(current_node != NULL)
+      check_if_current_useless();
+
+   while(current_node == NULL) {
+      if(!delay_queue.empty())
+         check_delayed_work();
+
+      if(!has_work()) {
+         if(!busy_wait())
+            return false;
+      }
+
+      current_node = pop_relaxed();
+      if(current_node != NULL)
+         claim_node(current_node);
+      else if(!queue_nodes.pop(current_node))
+         continue;
+
+      assert(current_node != NULL);
+      assert(current_node->in_queue());
+
+      check_if_current_useless();
+   }
+
+   ins_active;
+
+   assert(current_node != NULL);
+
+   return true;
+}
+
+node*
+threads_mq::get_work(void)
+{
+   if(!outbox.empty())
+      flush_outbox();
+
+   if(!set_next_node())
+      return NULL;
+
+   set_active_if_inactive();
+   assert(current_node != NULL);
+   assert(current_node->in_queue());
+   assert(current_node->unprocessed_facts);
+
+   return current_node;
+}
+
+void
+threads_mq::do_set_node_priority(thread_intrusive_node *tn, const double priority)
+{
+   heap_priority pr;
+   pr.float_priority = priority;
+
+   if(tn == current_node) {
+      tn->set_float_priority_level(priority);
+      return;
+   }
+
+   if(priority_queue::in_queue(tn)) {
+      // the node is in one of the shared queues, change it there
+      if(priority == 0.0) {
+         if(queues[tn->relaxed_queue].remove_if_present(tn)) {
+            queued--;
+            tn->set_float_priority_level(0.0);
+            tn->set_owner(this);
+            queue_nodes.push(tn);
+            return;
+         }
+      } else if(better(pr, tn->get_priority_level())) {
+         tn->set_float_priority_level(priority);
+         queues[tn->relaxed_queue].update(tn, pr);
+         return;
+      } else
+         return;
+   } else if(priority > 0.0 && tn->in_queue() && tn->get_owner() == this) {
+      // waiting in our normal queue
+      tn->set_float_priority_level(priority);
+      if(queue_nodes.remove(tn))
+         push_relaxed(tn);
+      return;
+   }
+
+   // the node is running or idle, it will be queued with this priority
+   tn->set_float_priority_level(priority);
+}
+
+void
+threads_mq::set_node_priority(node *n, const double priority)
+{
+   thread_intrusive_node *tn((thread_intrusive_node*)n);
+
+   tn->lock();
+   do_set_node_priority(tn, priority);
+   tn->unlock();
+}
+
+void
+threads_mq::add_node_priority(node *n, const double priority)
+{
+   thread_intrusive_node *tn((thread_intrusive_node*)n);
+
+   tn->lock();
+   do_set_node_priority(tn, tn->get_float_priority_level() + priority);
+   tn->unlock();
+}
+
+void
+threads_mq::schedule_next(node *n)
+{
+   static const double add = 100.0;
+   heap_priority top;
+   double prio(add);
+
+   if(sample_top(top))
+      prio = top.float_priority + add;
+
+   set_node_priority(n, prio);
+}
+
+void
+threads_mq::init(const size_t)
+{
+   database::iterator it(All->DATABASE->get_node_iterator(remote::self->find_first_node(id)));
+   database::iterator end(All->DATABASE->get_node_iterator(remote::self->find_last_node(id)));
+   const heap_priority initial(theProgram->get_initial_priority());
+
+   for(; it != end; ++it)
+   {
+      thread_intrusive_node *cur_node((thread_intrusive_node*)*it);
+
+      init_node(cur_node);
+      cur_node->set_priority_level(initial);
+      cur_node->set_in_queue(true);
+      add_to_queue(cur_node);
+
+      assert(cur_node->get_owner() == this);
+      assert(cur_node->in_queue());
+      assert(cur_node->unprocessed_facts);
+   }
+
+   threads_synchronize();
+}
+
+void
+threads_mq::start(const size_t num_threads)
+{
+   // normal priorities
+   assert(theProgram->get_priority_type() == FIELD_FLOAT);
+
+   if(theProgram->is_priority_desc())
+      priority_type = HEAP_FLOAT_DESC;
+   else
+      priority_type = HEAP_FLOAT_ASC;
+
+   num_queues = MQ_QUEUES_PER_THREAD * num_threads;
+   queues = new priority_queue[num_queues];
+   for(size_t i(0); i < num_queues; ++i)
+      queues[i].set_type(priority_type);
+
+   init_barriers(num_threads);
+   for(vm::process_id i(0); i < num_threads; ++i)
+      add_thread(new threads_mq(i));
+}
+
+void
+threads_mq::write_slice(statistics::slice& sl)
+{
+#ifdef INSTRUMENTATION
+   threads_sched::write_slice(sl);
+   sl.priority_pops = priority_pops;
+   sl.rank_error = priority_pops > 0 ? (double)rank_error / (double)priority_pops : 0.0;
+   priority_pops = 0;
+   rank_error = 0;
+#else
+   (void)sl;
+#endif
+}
+
+threads_mq::threads_mq(const vm::process_id _id):
+   threads_sched(_id)
+#ifdef INSTRUMENTATION
+   , priority_pops(0)
+   , rank_error(0)
+#endif
+{
+}
+
+threads_mq::~threads_mq(void)
+{
+   if(get_id() == 0) {
+      delete []queues;
+      queues = NULL;
+   }
+}
+
+}
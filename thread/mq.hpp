@@ -0,0 +1,103 @@
+
+#ifndef THREAD_MQ_HPP
+#define THREAD_MQ_HPP
+
+#include <vector>
+
+#include "sched/base.hpp"
+#include "thread/threads.hpp"
+#include "queue/safe_complex_pqueue.hpp"
+#include "sched/nodes/thread_intrusive.hpp"
+#include "sched/thread/threaded.hpp"
+#include "utils/atomic.hpp"
+
+namespace sched
+{
+
+// number of shared priority queues per thread
+#define MQ_QUEUES_PER_THREAD 2
+
+// prioritized nodes are kept in a set of shared priority queues instead of
+// the queue of their owner (MultiQueue). a thread runs the best of the first
+// nodes of two random queues, so the priority order is only approximate,
+// but any thread can run a node and change its priority in place
+class threads_mq: public threads_sched
+{
+protected:
+
+	typedef queue::intrusive_safe_complex_pqueue<thread_intrusive_node> priority_queue;
+
+   static priority_queue *queues;
+   static size_t num_queues;
+   static heap_type priority_type;
+   // nodes in all the queues
+   static utils::atomic<size_t> queued;
+
+#ifdef INSTRUMENTATION
+   size_t priority_pops;
+   size_t rank_error; // sum of the queues with a better first node on each pop
+
+   size_t count_better_queues(const heap_priority) const;
+#endif
+
+   static inline bool better(const heap_priority p1, const heap_priority p2)
+   {
+      if(priority_type == HEAP_FLOAT_DESC)
+         return p1.float_priority > p2.float_priority;
+      return p1.float_priority < p2.float_priority;
+   }
+
+   // node must be locked
+   void push_relaxed(thread_intrusive_node *);
+   thread_intrusive_node *pop_relaxed(void);
+   bool sample_top(heap_priority&);
+   void claim_node(thread_intrusive_node *);
+
+   virtual void add_to_queue(thread_intrusive_node *node)
+   {
+      if(node->has_priority_level())
+         push_relaxed(node);
+      else
+         queue_nodes.push(node);
+   }
+
+   virtual void add_to_queue_other(thread_intrusive_node *node)
+   {
+      if(node->has_priority_level())
+         push_relaxed(node);
+      else
+         queue_nodes.push_other(node);
+   }
+
+   virtual bool has_ready_nodes(void) const { return threads_sched::has_ready_nodes() || queued > 0; }
+   virtual bool check_if_current_useless(void);
+   bool set_next_node(void);
+   void do_set_node_priority(thread_intrusive_node *, const double);
+
+public:
+
+   virtual void init(const size_t);
+
+   virtual db::node* get_work(void);
+
+   virtual void set_node_priority(db::node *, const double);
+   virtual void add_node_priority(db::node *, const double);
+   virtual void schedule_next(db::node *);
+
+   static db::node *create_node(const db::node::node_id id, const db::node::node_id trans)
+   {
+      return new thread_intrusive_node(id, trans);
+   }
+
+   static void start(const size_t);
+
+   virtual void write_slice(statistics::slice&);
+
+   explicit threads_mq(const vm::process_id);
+
+   virtual ~threads_mq(void);
+};
+
+}
+
+#endif
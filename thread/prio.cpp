@@ -66,7 +66,7 @@ threads_prio::steal_node(void)
 
    if(steal_flag) {
       if(!queue_nodes.empty())
-         queue_nodes.pop_head(node);
+         queue_nodes.steal(node);
       else if(!prio_queue.empty())
          node = prio_queue.pop();
       steal_flag = false;
@@ -74,11 +74,28 @@ threads_prio::steal_node(void)
       if(!prio_queue.empty())
          node = prio_queue.pop();
       else if(!queue_nodes.empty())
-         queue_nodes.pop_head(node);
+         queue_nodes.steal(node);
       steal_flag = true;
    }
    return node;
 }
+
+size_t
+threads_prio::steal_nodes(thread_intrusive_node **nodes, const size_t max)
+{
+   // the priority queue does not support batches, take one node at a time
+   size_t stolen(0);
+
+   while(stolen < max) {
+      thread_intrusive_node *node(steal_node());
+
+      if(node == NULL)
+         break;
+      nodes[stolen++] = node;
+   }
+
+   return stolen;
+}
 #endif
 
 void
@@ -205,6 +222,8 @@ threads_prio::set_next_node(void)
    
    while (current_node == NULL) {   
       check_priority_buffer();
+      if(!delay_queue.empty())
+         check_delayed_work();
 		
       if(!has_work()) {
          if(!busy_wait())
@@ -219,7 +238,7 @@ threads_prio::set_next_node(void)
          taken_from_priority_queue = true;
 			goto loop_check;
 		} else if(!queue_nodes.empty()) {
-			const bool suc(queue_nodes.pop_head(current_node));
+			const bool suc(queue_nodes.pop(current_node));
 			if(!suc)
 				continue;
          taken_from_priority_queue = false;
@@ -243,11 +262,18 @@ loop_check:
 node*
 threads_prio::get_work(void)
 {
+   if(!outbox.empty())
+      flush_outbox();
    check_priority_buffer();
 	
    if(!set_next_node())
       return NULL;
 
+#ifdef TASK_STEALING
+   if(parked_threads > 0 && !theProgram->is_static_priority() && number_of_nodes() > 1)
+      wake_idle_thread();
+#endif
+
    set_active_if_inactive();
    assert(current_node != NULL);
    assert(current_node->in_queue());
@@ -269,12 +295,12 @@ threads_prio::end(void)
 	size_t total_prioritized(0);
 	size_t total_nonprioritized(0);
 	
-   database::map_nodes::iterator it(state::DATABASE->get_node_iterator(remote::self->find_first_node(id)));
-   database::map_nodes::iterator end(state::DATABASE->get_node_iterator(remote::self->find_last_node(id)));
+   database::iterator it(state::DATABASE->get_node_iterator(remote::self->find_first_node(id)));
+   database::iterator end(state::DATABASE->get_node_iterator(remote::self->find_last_node(id)));
    
    for(; it != end; ++it)
    {
-      thread_intrusive_node *cur_node((thread_intrusive_node*)it->second);
+      thread_intrusive_node *cur_node((thread_intrusive_node*)*it);
 		
 		if(cur_node->has_been_prioritized)
 			++total_prioritized;
@@ -424,7 +450,7 @@ threads_prio::do_set_node_priority(node *n, const double priority)
                tn->set_float_priority_level(0.0);
                //cout << "Remove from frio put into main\n";
                prio_queue.remove(tn);
-               queue_nodes.push_tail(tn);
+               queue_nodes.push(tn);
             } else {
                // priority > 0
                assert(priority > 0.0);
@@ -456,12 +482,12 @@ threads_prio::do_set_node_priority(node *n, const double priority)
 #ifdef DEBUG_PRIORITIES
             //cout << "Add node " << tn->get_id() << " with priority " << priority << endl;
 #endif
-            if(node_queue::in_queue(tn)) {
-               queue_nodes.remove(tn);
+            // the node may have been stolen in the meantime
+            if(queue_nodes.remove(tn)) {
+               //cout << "Remove from main put into prio\n";
+               assert(!priority_queue::in_queue(tn));
+               add_to_priority_queue(tn);
             }
-            //cout << "Remove from main put into prio\n";
-            assert(!priority_queue::in_queue(tn));
-            add_to_priority_queue(tn);
          }
 		}
 		assert(tn->in_queue());
@@ -492,18 +518,18 @@ threads_prio::init(const size_t)
 
    prio_queue.set_type(priority_type);
 
-   database::map_nodes::iterator it(All->DATABASE->get_node_iterator(remote::self->find_first_node(id)));
-   database::map_nodes::iterator end(All->DATABASE->get_node_iterator(remote::self->find_last_node(id)));
+   database::iterator it(All->DATABASE->get_node_iterator(remote::self->find_first_node(id)));
+   database::iterator end(All->DATABASE->get_node_iterator(remote::self->find_last_node(id)));
    const heap_priority initial(theProgram->get_initial_priority());
 
    if(initial.float_priority == 0.0) {
       for(; it != end; ++it)
       {
-         thread_intrusive_node *cur_node((thread_intrusive_node*)it->second);
+         thread_intrusive_node *cur_node((thread_intrusive_node*)*it);
       
          init_node(cur_node);
          cur_node->set_in_queue(true);
-      	queue_nodes.push_tail(cur_node);
+      	queue_nodes.push(cur_node);
 
          assert(cur_node->get_owner() == this);
          assert(cur_node->in_queue());
@@ -512,7 +538,7 @@ threads_prio::init(const size_t)
    } else {
       prio_queue.start_initial_insert(remote::self->find_owned_nodes(id));
       for(size_t i(0); it != end; ++it, ++i) {
-         thread_intrusive_node *cur_node((thread_intrusive_node*)it->second);
+         thread_intrusive_node *cur_node((thread_intrusive_node*)*it);
       
          init_node(cur_node);
          cur_node->set_priority_level(initial);
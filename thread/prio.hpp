@@ -9,7 +9,6 @@
 #include "thread/threads.hpp"
 #include "queue/safe_complex_pqueue.hpp"
 #include "sched/nodes/thread_intrusive.hpp"
-#include "queue/safe_double_queue.hpp"
 #include "sched/thread/threaded.hpp"
 
 namespace sched
@@ -49,6 +48,7 @@ protected:
 #ifdef TASK_STEALING
    bool steal_flag;
    thread_intrusive_node *steal_node(void);
+   virtual size_t steal_nodes(thread_intrusive_node **, const size_t);
    virtual size_t number_of_nodes(void) const {
       return queue_nodes.size() + prio_queue.size();
    }
@@ -73,11 +73,19 @@ protected:
 			add_to_priority_queue(node);
       } else {
          //cout << "Adding to normal\n";
-      	queue_nodes.push_tail(node);
+      	queue_nodes.push(node);
       }
    }
+
+   virtual void add_to_queue_other(thread_intrusive_node *node)
+   {
+		if(node->has_priority_level())
+			add_to_priority_queue(node);
+      else
+      	queue_nodes.push_other(node);
+   }
    
-   virtual bool has_work(void) const { return threads_sched::has_work() || !prio_queue.empty(); }
+   virtual bool has_ready_nodes(void) const { return threads_sched::has_ready_nodes() || !prio_queue.empty(); }
    void do_set_node_priority(db::node *, const double);
    void add_node_priority_other(db::node *, const double);
    void set_node_priority_other(db::node *, const double);
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <boost/thread/barrier.hpp>
 #include <climits>
+#include <unistd.h>
 
 #include "thread/threads.hpp"
 #include "db/database.hpp"
@@ -9,6 +10,8 @@
 #include "sched/thread/assert.hpp"
 #include "vm/state.hpp"
 #include "sched/common.hpp"
+#include "utils/numa.hpp"
+#include "process/machine.hpp"
 
 using namespace boost;
 using namespace std;
@@ -46,16 +49,54 @@ threads_sched::new_agg(work&)
    assert(false);
 }
 
-void
-threads_sched::new_work(node *from, node *to, vm::tuple *tpl, vm::predicate *pred, const ref_count count, const depth_t depth)
+// facts kept in an outbox before it is handed over to the owner thread
+#define OUTBOX_FLUSH_SIZE 64
+
+// marks the node as having new facts and returns the owner if it is another thread
+threads_sched*
+threads_sched::wake_node(thread_intrusive_node *tnode)
 {
-   assert(is_active());
-   (void)from;
-   
-   thread_node *tnode(dynamic_cast<thread_node*>(to));
+   tnode->lock();
+
+   threads_sched *owner(dynamic_cast<threads_sched*>(tnode->get_owner()));
+
+   tnode->mark_unprocessed();
+
+   if(owner == this) {
+      // stolen by us in the meantime
+      if(!tnode->in_queue()) {
+         tnode->set_in_queue(true);
+         add_to_queue(tnode);
+      }
+      owner = NULL;
+   } else {
+      if(!tnode->in_queue()) {
+         tnode->set_in_queue(true);
+         owner->add_to_queue_other(tnode);
+      }
+#ifdef INSTRUMENTATION
+      sent_facts_other_thread++;
+#endif
+   }
+
+   tnode->unlock();
+
+   return owner;
+}
+
+// adds the fact to the node and returns the owner if it is another thread
+threads_sched*
+threads_sched::deliver_work(thread_intrusive_node *tnode, vm::tuple *tpl, vm::predicate *pred, const ref_count count, const depth_t depth)
+{
+   if((pred->is_persistent_pred() || pred->is_reused_pred()) && tnode->get_owner() != this) {
+      // persistent facts for nodes of other threads are staged without the node lock,
+      // the lock is only needed to wake up the node
+      tnode->store.add_incoming_persistent(new simple_tuple(tpl, pred, count, depth));
+      return wake_node(tnode);
+   }
 
    tnode->lock();
-   
+
    threads_sched *owner(dynamic_cast<threads_sched*>(tnode->get_owner()));
 
    if(owner == this) {
@@ -72,8 +113,9 @@ threads_sched::new_work(node *from, node *to, vm::tuple *tpl, vm::predicate *pre
 #endif
       if(!tnode->in_queue()) {
          tnode->set_in_queue(true);
-         add_to_queue((thread_intrusive_node*)tnode);
+         add_to_queue(tnode);
       }
+      owner = NULL;
    } else {
 #ifdef FASTER_INDEXING
       if(tnode->running) {
@@ -94,22 +136,151 @@ threads_sched::new_work(node *from, node *to, vm::tuple *tpl, vm::predicate *pre
 #endif
       if(!tnode->in_queue()) {
          tnode->set_in_queue(true);
-         owner->add_to_queue((thread_intrusive_node*)tnode);
+         owner->add_to_queue_other(tnode);
       }
 #ifdef INSTRUMENTATION
       sent_facts_other_thread++;
 #endif
+   }
 
-      spinlock::scoped_lock l2(owner->lock);
-      
-      if(owner->is_inactive() && owner->has_work())
-      {
-         owner->set_active();
-         assert(owner->is_active());
+   tnode->unlock();
+
+   return owner;
+}
+
+bool
+threads_sched::take_local_work(node *to, vm::tuple *tpl, vm::predicate *pred, const ref_count count, const depth_t depth)
+{
+   thread_intrusive_node *tnode((thread_intrusive_node*)to);
+
+   // facts buffered for the node must go first (see new_work)
+   if(tnode->get_owner() != this || !outbox.empty())
+      return false;
+
+   tnode->lock();
+
+   // the node may have been stolen in the meantime
+   bool taken(tnode->get_owner() == this);
+
+   if(taken) {
+      assert(!tnode->running);
+#ifdef FASTER_INDEXING
+      tnode->internal_lock();
+#endif
+      taken = tnode->add_local_fact(tpl, pred, count, depth);
+#ifdef FASTER_INDEXING
+      tnode->internal_unlock();
+#endif
+      if(taken && !tnode->in_queue()) {
+         tnode->set_in_queue(true);
+         add_to_queue(tnode);
       }
    }
 
    tnode->unlock();
+
+#ifdef INSTRUMENTATION
+   if(taken)
+      sent_facts_same_thread++;
+#endif
+
+   return taken;
+}
+
+void
+threads_sched::new_work(node *from, node *to, vm::tuple *tpl, vm::predicate *pred, const ref_count count, const depth_t depth)
+{
+   assert(is_active());
+   (void)from;
+   
+   thread_intrusive_node *tnode((thread_intrusive_node*)to);
+   threads_sched *owner(dynamic_cast<threads_sched*>(tnode->get_owner()));
+
+   if(owner == this) {
+      // the node may have been stolen by us after we buffered facts for
+      // it, so those must go first to keep the order of the facts
+      if(!outbox.empty())
+         flush_outbox();
+      deliver_work(tnode, tpl, pred, count, depth);
+      return;
+   }
+
+   outgoing_fact fact = {tnode, tpl, pred, count, depth};
+
+   outbox.push_back(fact);
+   outbox_targets[owner->get_id()] = true;
+
+   if(outbox.size() >= OUTBOX_FLUSH_SIZE)
+      flush_outbox();
+}
+
+void
+threads_sched::flush_outbox(void)
+{
+   assert(!outbox.empty());
+
+   for(fact_batch::iterator it(outbox.begin()), end(outbox.end()); it != end; ++it) {
+      threads_sched *owner(deliver_work(it->node, it->tpl, it->pred, it->count, it->depth));
+
+      // nodes stolen in the meantime may have a new owner
+      if(owner != NULL)
+         outbox_targets[owner->get_id()] = true;
+   }
+
+#ifdef INSTRUMENTATION
+   sent_batches++;
+   batched_facts += outbox.size();
+#endif
+   outbox.clear();
+
+   // wake up each owner once for the whole batch
+   for(size_t i(0); i < outbox_targets.size(); ++i) {
+      if(outbox_targets[i]) {
+         threads_sched *target((threads_sched*)All->ALL_THREADS[i]);
+         outbox_targets[i] = false;
+         MAKE_OTHER_ACTIVE(target);
+      }
+   }
+}
+
+// longest sleep while waiting for delayed facts, in milliseconds,
+// so that work sent by other threads is not left waiting for too long
+#define DELAY_MAX_SLEEP 1
+
+void
+threads_sched::new_work_delay(node *from, node *to, vm::tuple *tpl, vm::predicate *pred, const ref_count count, const depth_t depth, const uint_val delay)
+{
+   assert(is_active());
+
+   delayed_fact fact = {from, (thread_intrusive_node*)to, tpl, pred, count, depth};
+
+   delay_queue.push(fact, get_timestamp() + delay);
+}
+
+void
+threads_sched::check_delayed_work(void)
+{
+   const unix_timestamp now(get_timestamp());
+
+   while(!delay_queue.empty() && delay_queue.top_priority() <= now) {
+      delayed_fact fact(delay_queue.pop());
+
+      if(fact.pred->is_action_pred())
+         All->MACHINE->run_action(this, fact.node, fact.tpl, fact.pred);
+      else
+         new_work(fact.from, fact.node, fact.tpl, fact.pred, fact.count, fact.depth);
+   }
+
+   if(!outbox.empty())
+      flush_outbox();
+
+   if(!delay_queue.empty() && !has_ready_nodes()) {
+      // nothing else to do, sleep until the next fact expires
+      const unix_timestamp wait(min(delay_queue.top_priority() - now, (unix_timestamp)DELAY_MAX_SLEEP));
+
+      ins_idle;
+      usleep(wait * 1000);
+   }
 }
 
 #ifdef COMPILE_MPI
@@ -121,6 +292,39 @@ threads_sched::new_work_remote(remote *, const node::node_id, message *)
 #endif
 
 #ifdef TASK_STEALING
+bool
+threads_sched::steal_from(threads_sched *target)
+{
+   // steal half of the victim's queue at once
+   const size_t size(min(max(target->number_of_nodes() / 2, (size_t)1), (size_t)MAX_STEAL_BATCH));
+   thread_intrusive_node *nodes[size];
+   const size_t stolen(target->steal_nodes(nodes, size));
+
+#ifdef INSTRUMENTATION
+   steal_attempts++;
+#endif
+
+   for(size_t i(0); i < stolen; ++i) {
+      thread_intrusive_node *node(nodes[i]);
+
+      node->lock();
+      check_stolen_node(node);
+      node->set_owner(this);
+      add_to_queue(node);
+      node->unlock();
+#ifdef INSTRUMENTATION
+      stolen_total++;
+#endif
+   }
+
+#ifdef INSTRUMENTATION
+   if(stolen > 0)
+      steal_batches++;
+#endif
+
+   return stolen > 0;
+}
+
 bool
 threads_sched::go_steal_nodes(void)
 {
@@ -130,55 +334,39 @@ threads_sched::go_steal_nodes(void)
    ins_sched;
    assert(is_active());
 
-   // roubar em ciclo
-   // verificar se o rand se inicializa com seeds diferentes
-   // tentar roubar mesmo que a fila so tenha 1 no
-
-   for(size_t i(0); i < All->NUM_THREADS; ++i) {
-      size_t tid((next_thread + i) % All->NUM_THREADS);
-      if(tid == get_id())
-         continue;
+   const bool numa(numa_enabled());
 
-      threads_sched *target((threads_sched*)All->ALL_THREADS[tid]);
+   // in NUMA mode the first pass only looks at threads on the same
+   // socket and the second pass at the threads on the other sockets
+   for(size_t pass(numa ? 0 : 1); pass < 2; ++pass) {
+      for(size_t i(0); i < All->NUM_THREADS; ++i) {
+         size_t tid((next_thread + i) % All->NUM_THREADS);
+         if(tid == get_id())
+            continue;
 
-      if(!target->is_active() || !target->has_work())
-         continue;
-      size_t size = 1;
+         if(numa && (pass == 0) != numa_same_socket(tid, get_id()))
+            continue;
 
-      assert(size > 0);
+         threads_sched *target((threads_sched*)All->ALL_THREADS[tid]);
 
-      while(size > 0) {
-         thread_intrusive_node *node(target->steal_node());
+         if(!target->is_active() || !target->has_ready_nodes())
+            continue;
 
-         if(node == NULL)
-            break;
-
-         node->lock();
-         check_stolen_node(node);
-         node->set_owner(this);
-         add_to_queue(node);
-         node->unlock();
-#ifdef INSTRUMENTATION
-         stolen_total++;
-#endif
-         --size;
-      }
-      if(size == 0) {
-         // set the next thread to the current one
-         next_thread = tid;
-         return true;
+         if(steal_from(target)) {
+            // set the next thread to the current one
+            next_thread = tid;
+            return true;
+         }
       }
    }
 
    return false;
 }
 
-thread_intrusive_node*
-threads_sched::steal_node(void)
+size_t
+threads_sched::steal_nodes(thread_intrusive_node **nodes, const size_t max)
 {
-   thread_intrusive_node *node(NULL);
-   queue_nodes.pop_tail(node);
-   return node;
+   return queue_nodes.steal_batch(nodes, max);
 }
 
 size_t
@@ -215,6 +403,10 @@ threads_sched::busy_wait(void)
 #ifdef TASK_STEALING
    size_t count(0);
 #endif
+
+   idle.reset();
+   // objects freed while looking for work are given back before idling
+   mem::get_pool()->flush_remote_batches();
    
    while(!has_work()) {
 #ifdef TASK_STEALING
@@ -239,7 +431,16 @@ threads_sched::busy_wait(void)
 #endif
       ins_idle;
       BUSY_LOOP_MAKE_INACTIVE()
+      if(parked_threads > 0 && all_threads_finished())
+         wake_all_idle();
       BUSY_LOOP_CHECK_TERMINATION_THREADS()
+#ifdef TASK_STEALING
+      // after sleeping, others may have work to steal by now
+      if(idle_wait())
+         count = backoff - 1;
+#else
+      idle_wait();
+#endif
    }
    
    // since queue pushing and state setting are done in
@@ -252,6 +453,56 @@ threads_sched::busy_wait(void)
    return true;
 }
 
+// spins, then sleeps when the thread has been idle for a while.
+// returns true if the thread was put to sleep
+bool
+threads_sched::idle_wait(void)
+{
+   if(!idle.should_park()) {
+      idle.spin();
+      return false;
+   }
+
+   idle.prepare_park();
+
+   // work sent after this point will wake us up
+   if(has_work() || all_threads_finished() || stop_flag) {
+      idle.cancel_park();
+      return false;
+   }
+
+   parked_threads++;
+   idle.park();
+   parked_threads--;
+
+   return true;
+}
+
+// wakes up a sleeping thread so that it can steal some of our nodes
+void
+threads_sched::wake_idle_thread(void)
+{
+   for(size_t i(0); i < All->NUM_THREADS; ++i) {
+      threads_sched *target((threads_sched*)All->ALL_THREADS[(get_id() + i + 1) % All->NUM_THREADS]);
+
+      if(target->idle.is_sleeping()) {
+         target->idle.wake();
+         return;
+      }
+   }
+}
+
+void
+threads_sched::wake_all_idle(void)
+{
+   for(size_t i(0); i < All->NUM_THREADS; ++i) {
+      threads_sched *target((threads_sched*)All->ALL_THREADS[i]);
+
+      if(target != this)
+         target->idle.wake();
+   }
+}
+
 bool
 threads_sched::terminate_iteration(void)
 {
@@ -280,6 +531,17 @@ threads_sched::check_if_current_useless(void)
    }
    
    assert(current_node->unprocessed_facts);
+
+   if(current_node->yielded && has_ready_nodes()) {
+      // the node ran out of its quota, run the other nodes first
+      current_node->yielded = false;
+      current_node->lock();
+      add_to_queue(current_node);
+      current_node->unlock();
+      current_node = NULL;
+      return true;
+   }
+
    return false;
 }
 
@@ -290,12 +552,15 @@ threads_sched::set_next_node(void)
       check_if_current_useless();
    
    while (current_node == NULL) {   
+      if(!delay_queue.empty())
+         check_delayed_work();
+
       if(!has_work()) {
          if(!busy_wait())
             return false;
       }
 
-      if(!queue_nodes.pop_head(current_node))
+      if(!queue_nodes.pop(current_node))
          continue;
       
       assert(current_node->in_queue());
@@ -314,9 +579,18 @@ threads_sched::set_next_node(void)
 node*
 threads_sched::get_work(void)
 {  
+   // the previous node is done, hand over what it sent to the other threads
+   if(!outbox.empty())
+      flush_outbox();
+
    if(!set_next_node())
       return NULL;
 
+#ifdef TASK_STEALING
+   if(parked_threads > 0 && !theProgram->is_static_priority() && number_of_nodes() > 1)
+      wake_idle_thread();
+#endif
+
    set_active_if_inactive();
    ins_active;
    assert(current_node != NULL);
@@ -337,12 +611,12 @@ threads_sched::init(const size_t)
    const node::node_id first_node(remote::self->find_first_node(id));
    const node::node_id last_node(remote::self->find_last_node(id));
 
-   database::map_nodes::iterator it(All->DATABASE->get_node_iterator(first_node));
-   database::map_nodes::iterator end(All->DATABASE->get_node_iterator(last_node));
+   database::iterator it(All->DATABASE->get_node_iterator(first_node));
+   database::iterator end(All->DATABASE->get_node_iterator(last_node));
    
    for(; it != end; ++it)
    {
-      thread_intrusive_node *cur_node((thread_intrusive_node*)it->second);
+      thread_intrusive_node *cur_node((thread_intrusive_node*)*it);
       
       init_node(cur_node);
       cur_node->set_in_queue(true);
@@ -364,12 +638,20 @@ threads_sched::write_slice(statistics::slice& sl)
    sl.sent_facts_same_thread = sent_facts_same_thread;
    sl.sent_facts_other_thread = sent_facts_other_thread;
    sl.sent_facts_other_thread_now = sent_facts_other_thread_now;
+   sl.sent_batches = sent_batches;
+   sl.batch_size = sent_batches > 0 ? batched_facts / sent_batches : 0;
    sent_facts_same_thread = 0;
    sent_facts_other_thread = 0;
    sent_facts_other_thread_now = 0;
+   sent_batches = 0;
+   batched_facts = 0;
 #ifdef TASK_STEALING
    sl.stolen_nodes = stolen_total;
+   sl.steal_attempts = steal_attempts;
+   sl.steal_batches = steal_batches;
    stolen_total = 0;
+   steal_attempts = 0;
+   steal_batches = 0;
 #endif
 #else
    (void)sl;
@@ -378,21 +660,28 @@ threads_sched::write_slice(statistics::slice& sl)
 
 threads_sched::threads_sched(const vm::process_id _id):
    base(_id),
+   threaded(_id),
    current_node(NULL)
 #ifdef TASK_STEALING
    , rand(time(NULL) + _id * 10)
    , next_thread(rand(All->NUM_THREADS))
    , backoff(STEALING_ROUND_MAX)
 #endif
+   , outbox_targets(All->NUM_THREADS, false)
 #ifdef INSTRUMENTATION
    , sent_facts_same_thread(0)
    , sent_facts_other_thread(0)
    , sent_facts_other_thread_now(0)
+   , sent_batches(0)
+   , batched_facts(0)
 #ifdef TASK_STEALING
    , stolen_total(0)
+   , steal_attempts(0)
+   , steal_batches(0)
 #endif
 #endif
 {
+   outbox.reserve(OUTBOX_FLUSH_SIZE);
 }
 
 threads_sched::~threads_sched(void)
@@ -11,10 +11,15 @@
 #include "sched/thread/threaded.hpp"
 #include "sched/nodes/thread_intrusive.hpp"
 #include "queue/safe_complex_pqueue.hpp"
-#include "queue/safe_double_queue.hpp"
+#include "queue/work_stealing_deque.hpp"
+#include "queue/safe_general_pqueue.hpp"
 #include "utils/random.hpp"
+#include "utils/time.hpp"
+#include "mem/allocator.hpp"
 
 #define TASK_STEALING 1
+// most nodes taken from another thread in one steal
+#define MAX_STEAL_BATCH 256
 
 namespace sched
 {
@@ -24,7 +29,7 @@ class threads_sched: public sched::base,
 {
 protected:
    
-   typedef queue::intrusive_safe_double_queue<thread_intrusive_node> node_queue;
+   typedef queue::intrusive_work_stealing_deque<thread_intrusive_node> node_queue;
    node_queue queue_nodes;
    
    thread_intrusive_node *current_node;
@@ -34,20 +39,58 @@ protected:
    size_t backoff;
 #endif
 
+   // facts for nodes owned by other threads are buffered in send order
+   // and handed over in batches, waking up each destination thread once
+   struct outgoing_fact {
+      thread_intrusive_node *node;
+      vm::tuple *tpl;
+      vm::predicate *pred;
+      vm::ref_count count;
+      vm::depth_t depth;
+   };
+   typedef std::vector<outgoing_fact, mem::allocator<outgoing_fact> > fact_batch;
+
+   fact_batch outbox;
+   // destination threads of the facts in the outbox
+   std::vector<bool> outbox_targets;
+
+   threads_sched *wake_node(thread_intrusive_node *);
+   threads_sched *deliver_work(thread_intrusive_node *, vm::tuple *, vm::predicate *, const vm::ref_count, const vm::depth_t);
+   void flush_outbox(void);
+
+   // facts sent with a delay are kept by the sender until they expire
+   struct delayed_fact {
+      db::node *from;
+      thread_intrusive_node *node;
+      vm::tuple *tpl;
+      vm::predicate *pred;
+      vm::ref_count count;
+      vm::depth_t depth;
+   };
+
+   queue::general_pqueue<delayed_fact, utils::unix_timestamp> delay_queue;
+
+   void check_delayed_work(void);
+
 #ifdef INSTRUMENTATION
    size_t sent_facts_same_thread;
    size_t sent_facts_other_thread;
    size_t sent_facts_other_thread_now;
+   size_t sent_batches;
+   size_t batched_facts;
 #endif
 
 #ifdef TASK_STEALING
 #ifdef INSTRUMENTATION
    size_t stolen_total;
+   size_t steal_attempts;
+   size_t steal_batches;
 #endif
 
    void clear_steal_requests(void);
+   bool steal_from(threads_sched *);
    bool go_steal_nodes(void);
-   virtual thread_intrusive_node* steal_node(void);
+   virtual size_t steal_nodes(thread_intrusive_node **, const size_t);
    virtual size_t number_of_nodes(void) const;
    virtual void check_stolen_node(thread_intrusive_node *) {};
 #endif
@@ -60,13 +103,26 @@ protected:
    void make_inactive(void);
    virtual void generate_aggs(void);
    virtual bool busy_wait(void);
+   bool idle_wait(void);
+   void wake_idle_thread(void);
+   void wake_all_idle(void);
    
+   // called by the owner thread
    virtual void add_to_queue(thread_intrusive_node *node)
    {
-      queue_nodes.push_tail(node);
+      queue_nodes.push(node);
+   }
+
+   // called by the other threads
+   virtual void add_to_queue_other(thread_intrusive_node *node)
+   {
+      queue_nodes.push_other(node);
    }
    
-   virtual bool has_work(void) const { return !queue_nodes.empty(); }
+   virtual bool has_ready_nodes(void) const { return !queue_nodes.empty(); }
+   // delayed facts keep the thread active, so that the
+   // termination barrier does not finish while they are pending
+   inline bool has_work(void) const { return has_ready_nodes() || !delay_queue.empty(); }
 
    virtual void killed_while_active(void);
    
@@ -76,6 +132,8 @@ public:
    
    virtual void new_agg(process::work&);
    virtual void new_work(db::node *, db::node *, vm::tuple *, vm::predicate *, const vm::ref_count, const vm::depth_t);
+   virtual bool take_local_work(db::node *, vm::tuple *, vm::predicate *, const vm::ref_count, const vm::depth_t);
+   virtual void new_work_delay(db::node *, db::node *, vm::tuple *, vm::predicate *, const vm::ref_count, const vm::depth_t, const vm::uint_val);
 #ifdef COMPILE_MPI
    virtual void new_work_remote(process::remote *, const db::node::node_id, message *);
 #endif
@@ -0,0 +1,122 @@
+
+#ifndef UTILS_IDLE_HPP
+#define UTILS_IDLE_HPP
+
+#include <sched.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "utils/atomic.hpp"
+
+namespace utils
+{
+
+// rounds spent spinning on the condition before pausing the core
+#define IDLE_SPIN_ROUNDS 64
+// rounds spent pausing the core before giving up the CPU
+#define IDLE_PAUSE_ROUNDS 1024
+// longest time a parked thread sleeps before checking again, in microseconds
+#define IDLE_PARK_TIMEOUT 500
+
+static inline void
+cpu_relax(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+   __asm__ __volatile__("pause" ::: "memory");
+#else
+   __sync_synchronize();
+#endif
+}
+
+// waiting strategy for loops that spin on a condition set by other threads:
+// spin for a while, then pause the core (leaving it to the hyperthread sibling)
+// and then yield the CPU to other processes
+class backoff
+{
+private:
+
+   size_t rounds;
+
+public:
+
+   inline bool spinning(void) const { return rounds < IDLE_PAUSE_ROUNDS; }
+
+   inline void reset(void) { rounds = 0; }
+
+   inline void wait(void)
+   {
+      if(rounds < IDLE_SPIN_ROUNDS)
+         ++rounds;
+      else if(rounds < IDLE_PAUSE_ROUNDS) {
+         ++rounds;
+         cpu_relax();
+      } else
+         sched_yield();
+   }
+
+   explicit backoff(void): rounds(0) {}
+};
+
+// backoff for threads without work that, instead of yielding, parks the thread
+// until another thread calls wake() or a timeout expires. to avoid losing wake
+// ups the waiter calls prepare_park(), checks for work and only then park()
+class idle_waiter
+{
+private:
+
+   boost::mutex mtx;
+   boost::condition_variable cond;
+   volatile bool sleeping;
+   volatile bool signaled;
+   backoff bo;
+
+public:
+
+   inline bool should_park(void) const { return !bo.spinning(); }
+   inline bool is_sleeping(void) const { return sleeping; }
+
+   inline void spin(void) { bo.wait(); }
+   inline void reset(void) { bo.reset(); }
+
+   inline void prepare_park(void)
+   {
+      sleeping = true;
+      __sync_synchronize();
+   }
+
+   inline void cancel_park(void) { sleeping = false; }
+
+   // returns true if woken up by another thread
+   bool park(void)
+   {
+      boost::mutex::scoped_lock l(mtx);
+      bool woken(signaled);
+
+      if(!woken) {
+         cond.timed_wait(l, boost::posix_time::microseconds(IDLE_PARK_TIMEOUT));
+         woken = signaled;
+      }
+      signaled = false;
+      sleeping = false;
+
+      return woken;
+   }
+
+   // the caller must have published its work before
+   inline void wake(void)
+   {
+      __sync_synchronize();
+      if(sleeping) {
+         boost::mutex::scoped_lock l(mtx);
+         signaled = true;
+         cond.notify_one();
+      }
+   }
+
+   explicit idle_waiter(void): sleeping(false), signaled(false) {}
+};
+
+}
+
+#endif
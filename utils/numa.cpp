@@ -0,0 +1,182 @@
+
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+#include <assert.h>
+#ifdef USE_NUMA
+#include <numa.h>
+#endif
+
+#include "utils/numa.hpp"
+#include "utils/utils.hpp"
+
+using namespace std;
+
+namespace utils
+{
+
+static bool enabled(false);
+// cpu and socket used by each thread
+static vector<int> thread_cpu;
+static vector<int> thread_socket;
+static size_t num_sockets(1);
+
+#ifdef USE_NUMA
+static int
+read_core_id(const int cpu)
+{
+   ifstream fp((string("/sys/devices/system/cpu/cpu") + to_string(cpu) + "/topology/core_id").c_str());
+   int core(cpu);
+
+   if(fp.is_open())
+      fp >> core;
+
+   return core;
+}
+
+typedef pair<int, int> cpu_rank;
+
+// sort cpus so that different physical cores come before hyperthreads
+static vector<int>
+order_socket_cpus(const vector<int>& cpus)
+{
+   vector<cpu_rank> ranked;
+   vector<int> cores;
+
+   for(size_t i(0); i < cpus.size(); ++i) {
+      const int core(read_core_id(cpus[i]));
+      const int rank(count(cores.begin(), cores.end(), core));
+
+      cores.push_back(core);
+      ranked.push_back(cpu_rank(rank, cpus[i]));
+   }
+
+   sort(ranked.begin(), ranked.end());
+
+   vector<int> ret;
+   for(size_t i(0); i < ranked.size(); ++i)
+      ret.push_back(ranked[i].second);
+   return ret;
+}
+#endif
+
+bool
+numa_init(const size_t num_threads)
+{
+#ifdef USE_NUMA
+   if(numa_available() < 0)
+      return false;
+
+   const int max_node(numa_max_node());
+   vector< vector<int> > socket_cpus(max_node + 1, vector<int>());
+
+   for(int cpu(0); cpu < numa_num_configured_cpus(); ++cpu) {
+      if(!numa_bitmask_isbitset(numa_all_cpus_ptr, cpu))
+         continue;
+
+      const int node(numa_node_of_cpu(cpu));
+      if(node >= 0)
+         socket_cpus[node].push_back(cpu);
+   }
+
+   vector<int> sockets;
+   for(int node(0); node <= max_node; ++node) {
+      if(!socket_cpus[node].empty()) {
+         sockets.push_back(node);
+         socket_cpus[node] = order_socket_cpus(socket_cpus[node]);
+      }
+   }
+
+   if(sockets.empty())
+      return false;
+
+   num_sockets = sockets.size();
+   thread_cpu.resize(num_threads);
+   thread_socket.resize(num_threads);
+
+   // threads are split in contiguous blocks, one block per socket
+   for(size_t i(0); i < num_threads; ++i) {
+      const size_t block((i * num_sockets) / num_threads);
+      const size_t first((block * num_threads + num_sockets - 1) / num_sockets);
+      const vector<int>& cpus(socket_cpus[sockets[block]]);
+
+      thread_socket[i] = sockets[block];
+      thread_cpu[i] = cpus[(i - first) % cpus.size()];
+   }
+
+   enabled = true;
+   return true;
+#else
+   (void)num_threads;
+   return false;
+#endif
+}
+
+bool
+numa_enabled(void)
+{
+   return enabled;
+}
+
+void
+numa_pin_thread(const size_t id)
+{
+   assert(enabled);
+   assert(id < thread_cpu.size());
+
+   cpu_set_t set;
+
+   CPU_ZERO(&set);
+   CPU_SET(thread_cpu[id], &set);
+
+   pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+}
+
+int
+numa_thread_socket(const size_t id)
+{
+   if(!enabled)
+      return -1;
+
+   assert(id < thread_socket.size());
+   return thread_socket[id];
+}
+
+bool
+numa_same_socket(const size_t id1, const size_t id2)
+{
+   return numa_thread_socket(id1) == numa_thread_socket(id2);
+}
+
+size_t
+numa_num_sockets(void)
+{
+   return num_sockets;
+}
+
+void*
+numa_allocate(const size_t size, const int socket)
+{
+#ifdef USE_NUMA
+   assert(socket >= 0);
+   return numa_alloc_onnode(size, socket);
+#else
+   (void)socket;
+   return malloc(size);
+#endif
+}
+
+void
+numa_deallocate(void *ptr, const size_t size)
+{
+#ifdef USE_NUMA
+   numa_free(ptr, size);
+#else
+   (void)size;
+   free(ptr);
+#endif
+}
+
+}
@@ -0,0 +1,29 @@
+
+#ifndef UTILS_NUMA_HPP
+#define UTILS_NUMA_HPP
+
+#include <cstdlib>
+
+#include "conf.hpp"
+
+namespace utils
+{
+
+// NUMA mode: threads are pinned to cores, grouped by socket so that
+// consecutive thread ids (and thus consecutive node ranges) share a socket.
+// returns false if NUMA support is not available
+bool numa_init(const size_t);
+bool numa_enabled(void);
+
+void numa_pin_thread(const size_t);
+int numa_thread_socket(const size_t);
+bool numa_same_socket(const size_t, const size_t);
+size_t numa_num_sockets(void);
+
+// allocate memory on a given socket
+void *numa_allocate(const size_t, const int);
+void numa_deallocate(void *, const size_t);
+
+}
+
+#endif
@@ -3,6 +3,7 @@
 #define UTILS_TIME_HPP
 
 #include <ostream>
+#include <sys/resource.h>
 #include <boost/date_time.hpp>
 
 namespace utils
@@ -90,6 +91,27 @@ get_timestamp(void)
       tv.tv_usec/1000;
 }
 
+// monotonic clock in nanoseconds
+inline uint64_t
+get_nanoseconds(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+
+   return ts.tv_sec * (uint64_t)1000000000 + ts.tv_nsec;
+}
+
+// CPU time used by all the threads of the process, in milliseconds
+inline size_t
+get_cpu_time(void)
+{
+   struct rusage usage;
+   getrusage(RUSAGE_SELF, &usage);
+
+   return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * (size_t)1000 +
+      (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+}
+
 }
 
 #endif
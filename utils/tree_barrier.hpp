@@ -4,6 +4,7 @@
 
 #include "utils/atomic.hpp"
 #include "utils/utils.hpp"
+#include "utils/idle.hpp"
 
 #include <stdio.h>
 
@@ -36,18 +37,22 @@ private:
       inline void wait(void)
       {
          bool my_sense(thread_sense);
+         utils::backoff bo;
          
          if(id == 0)
             assert(parent == NULL);
          
-         while(children_count > 0) {}
+         while(children_count > 0)
+            bo.wait();
          
          children_count = count;
          
          if(parent != NULL) {
             // not root
             parent->children_count--;
-            while(outer->sense != my_sense) {}
+            bo.reset();
+            while(outer->sense != my_sense)
+               bo.wait();
          } else {
             // root
             outer->sense = !outer->sense;
@@ -200,6 +200,14 @@ struct bitmap {
       }
    }
 
+   // set all bits in our bitmap that are set in the other bitmap
+   inline void set_bits(const bitmap& other, const size_t size)
+   {
+      first = first | other.first;
+      for(size_t i(0); i < size - 1; ++i)
+         *(rest + i) = *(rest + i) | *(other.rest + i);
+   }
+
    // and the two arguments and set the corresponding bits on our bitmap
    inline void set_bits_of_and_result(const bitmap& a, const bitmap& b, const size_t size)
    {
@@ -0,0 +1,324 @@
+
+#include "vm/decoded.hpp"
+#include "vm/program.hpp"
+
+using namespace std;
+using namespace vm;
+using namespace vm::instr;
+
+namespace vm
+{
+
+const decoded_instr*
+decoded_code::find(const byte_code code, const vector<int>& index, const pcounter pc) const
+{
+   const size_t off(pc - code);
+
+   if(off >= index.size() || index[off] < 0)
+      return &instrs.back(); // outside of this code
+
+   return &instrs[index[off]];
+}
+
+void
+decoded_code::decode_instr(decoded_instr& d, const byte_code code, const vector<int>& index, program *prog)
+{
+   const pcounter pc(d.pc);
+
+   switch(d.op) {
+      case IF_INSTR:
+         d.reg1 = if_reg(pc);
+         d.jump = find(code, index, pc + if_jump(pc));
+         break;
+      case IF_ELSE_INSTR:
+         d.reg1 = if_reg(pc);
+         d.jump = find(code, index, pc + if_else_jump_else(pc));
+         break;
+      case JUMP_INSTR:
+         d.jump = find(code, index, pc + jump_get(pc, instr_size) + JUMP_BASE);
+         break;
+      case RETURN_SELECT_INSTR:
+         d.jump = find(code, index, pc + return_select_jump(pc));
+         break;
+      case RESET_LINEAR_INSTR:
+         d.jump = find(code, index, pc + reset_linear_jump(pc));
+         break;
+
+      case PERS_ITER_INSTR:
+      case LINEAR_ITER_INSTR:
+      case RLINEAR_ITER_INSTR:
+      case OPERS_ITER_INSTR:
+      case OLINEAR_ITER_INSTR:
+      case ORLINEAR_ITER_INSTR:
+         // the body of the iteration is the next instruction
+         assert(find(code, index, pc + iter_inner_jump(pc)) == &d + 1);
+         d.pred = prog->get_predicate(iter_predicate(pc));
+         d.reg1 = iter_reg(pc);
+         d.jump = find(code, index, pc + iter_outer_jump(pc));
+         break;
+
+      case SELECT_INSTR: {
+         const pcounter hash_start(select_hash_start(pc));
+         const size_t hash_size(select_hash_size(pc));
+
+         d.jump = find(code, index, pc + select_size(pc));
+         d.uint_value = hash_size;
+         d.targets = new const decoded_instr*[hash_size];
+         for(size_t i(0); i < hash_size; ++i) {
+            const code_size_t hashed(select_hash(hash_start, i));
+            if(hashed == 0)
+               d.targets[i] = d.jump;
+            else
+               d.targets[i] = find(code, index, select_hash_code(hash_start, hash_size, hashed));
+         }
+      }
+      break;
+
+      case CALLF_INSTR:
+         d.fun = prog->get_function(callf_get_id(pc));
+         break;
+
+      case ALLOC_INSTR:
+         d.pred = prog->get_predicate(alloc_predicate(pc));
+         d.reg1 = alloc_reg(pc);
+         break;
+
+      case ADDLINEAR_INSTR:
+      case ADDPERS_INSTR:
+      case RUNACTION_INSTR:
+      case ENQUEUE_LINEAR_INSTR:
+      case REMOVE_INSTR:
+      case UPDATE_INSTR:
+      case MVHOSTREG_INSTR:
+      case MVNILREG_INSTR:
+         d.reg1 = pcounter_reg(pc + instr_size);
+         break;
+
+      case SEND_INSTR:
+         d.reg1 = send_msg(pc);
+         d.reg2 = send_dest(pc);
+         break;
+
+      case NOT_INSTR:
+      case TESTNIL_INSTR:
+      case FLOAT_INSTR:
+      case MVREGREG_INSTR:
+         d.reg1 = pcounter_reg(pc + instr_size);
+         d.reg2 = pcounter_reg(pc + instr_size + reg_val_size);
+         break;
+
+      case RULE_INSTR:
+         d.uint_value = rule_get_id(pc);
+         break;
+
+      case PUSHN_INSTR:
+         d.uint_value = push_n(pc);
+         break;
+
+      case MVINTREG_INSTR:
+         d.int_value = pcounter_int(pc + instr_size);
+         d.reg1 = pcounter_reg(pc + instr_size + int_size);
+         break;
+      case MVFLOATREG_INSTR:
+         d.float_value = pcounter_float(pc + instr_size);
+         d.reg1 = pcounter_reg(pc + instr_size + float_size);
+         break;
+      case MVINTFIELD_INSTR:
+         d.int_value = pcounter_int(pc + instr_size);
+         d.field1 = val_field_num(pc + instr_size + int_size);
+         d.reg1 = val_field_reg(pc + instr_size + int_size);
+         break;
+      case MVFLOATFIELD_INSTR:
+         d.float_value = pcounter_float(pc + instr_size);
+         d.field1 = val_field_num(pc + instr_size + float_size);
+         d.reg1 = val_field_reg(pc + instr_size + float_size);
+         break;
+      case MVFIELDREG_INSTR:
+         d.field1 = val_field_num(pc + instr_size);
+         d.reg1 = val_field_reg(pc + instr_size);
+         d.reg2 = pcounter_reg(pc + instr_size + field_size);
+         break;
+      case MVREGFIELD_INSTR:
+         d.reg1 = pcounter_reg(pc + instr_size);
+         d.field1 = val_field_num(pc + instr_size + reg_val_size);
+         d.reg2 = val_field_reg(pc + instr_size + reg_val_size);
+         break;
+      case MVFIELDFIELD_INSTR:
+         d.field1 = val_field_num(pc + instr_size);
+         d.reg1 = val_field_reg(pc + instr_size);
+         d.field2 = val_field_num(pc + instr_size + field_size);
+         d.reg2 = val_field_reg(pc + instr_size + field_size);
+         break;
+      case MVHOSTFIELD_INSTR:
+         d.field1 = val_field_num(pc + instr_size);
+         d.reg1 = val_field_reg(pc + instr_size);
+         break;
+
+      case ADDRNOTEQUAL_INSTR:
+      case ADDREQUAL_INSTR:
+      case INTMINUS_INSTR:
+      case INTEQUAL_INSTR:
+      case INTNOTEQUAL_INSTR:
+      case INTPLUS_INSTR:
+      case INTLESSER_INSTR:
+      case INTGREATEREQUAL_INSTR:
+      case INTLESSEREQUAL_INSTR:
+      case INTGREATER_INSTR:
+      case INTMUL_INSTR:
+      case INTDIV_INSTR:
+      case INTMOD_INSTR:
+      case FLOATPLUS_INSTR:
+      case FLOATMINUS_INSTR:
+      case FLOATMUL_INSTR:
+      case FLOATDIV_INSTR:
+      case FLOATEQUAL_INSTR:
+      case FLOATNOTEQUAL_INSTR:
+      case FLOATLESSER_INSTR:
+      case FLOATLESSEREQUAL_INSTR:
+      case FLOATGREATER_INSTR:
+      case FLOATGREATEREQUAL_INSTR:
+      case BOOLOR_INSTR:
+      case BOOLEQUAL_INSTR:
+      case BOOLNOTEQUAL_INSTR:
+         d.reg1 = pcounter_reg(pc + instr_size);
+         d.reg2 = pcounter_reg(pc + instr_size + reg_val_size);
+         d.reg3 = pcounter_reg(pc + instr_size + 2 * reg_val_size);
+         break;
+
+      default:
+         // operands are read from the byte code
+         break;
+   }
+}
+
+static inline bool
+is_fusable_move(const utils::byte op)
+{
+   switch(op) {
+      case MVFIELDFIELD_INSTR:
+      case MVFIELDREG_INSTR:
+      case MVREGFIELD_INSTR:
+      case MVINTFIELD_INSTR:
+      case MVFLOATFIELD_INSTR:
+      case MVHOSTFIELD_INSTR:
+         return true;
+      default:
+         return false;
+   }
+}
+
+static inline utils::byte
+fused_test_if(const utils::byte op)
+{
+   switch(op) {
+      case INTLESSER_INSTR: return FUSED_INTLESSER_IF_INSTR;
+      case INTLESSEREQUAL_INSTR: return FUSED_INTLESSEREQUAL_IF_INSTR;
+      case INTGREATER_INSTR: return FUSED_INTGREATER_IF_INSTR;
+      case INTGREATEREQUAL_INSTR: return FUSED_INTGREATEREQUAL_IF_INSTR;
+      case FLOATEQUAL_INSTR: return FUSED_FLOATEQUAL_IF_INSTR;
+      case FLOATNOTEQUAL_INSTR: return FUSED_FLOATNOTEQUAL_IF_INSTR;
+      case FLOATLESSER_INSTR: return FUSED_FLOATLESSER_IF_INSTR;
+      case FLOATLESSEREQUAL_INSTR: return FUSED_FLOATLESSEREQUAL_IF_INSTR;
+      case FLOATGREATER_INSTR: return FUSED_FLOATGREATER_IF_INSTR;
+      case FLOATGREATEREQUAL_INSTR: return FUSED_FLOATGREATEREQUAL_IF_INSTR;
+      case ADDREQUAL_INSTR: return FUSED_ADDREQUAL_IF_INSTR;
+      case ADDRNOTEQUAL_INSTR: return FUSED_ADDRNOTEQUAL_IF_INSTR;
+      default: return 0;
+   }
+}
+
+// replaces the head of common straight line sequences by a superinstruction,
+// the other instructions are kept since they may be jump targets
+void
+decoded_code::fuse(void)
+{
+   const size_t total(instrs.size() - 1);
+
+   for(size_t i(0); i + 1 < total; ++i) {
+      decoded_instr& d(instrs[i]);
+      const decoded_instr& next(instrs[i + 1]);
+
+      switch(d.op) {
+         case MVFIELDFIELD_INSTR:
+            if(next.op == MVFIELDFIELD_INSTR)
+               d.exec_op = FUSED_MVFIELDFIELD2_INSTR;
+            break;
+         case MVFIELDREG_INSTR:
+            if(next.op == MVFIELDREG_INSTR)
+               d.exec_op = FUSED_MVFIELDREG2_INSTR;
+            break;
+         case ALLOC_INSTR: {
+            size_t moves(0);
+
+            while(i + 1 + moves < total && is_fusable_move(instrs[i + 1 + moves].op))
+               ++moves;
+
+            const decoded_instr& last(instrs[i + 1 + moves]);
+
+            if(moves > 0 && (last.op == SEND_INSTR || last.op == ADDLINEAR_INSTR)) {
+               d.exec_op = FUSED_ALLOC_SEND_INSTR;
+               d.uint_value = moves;
+            }
+         }
+         break;
+         default: {
+            // iterators are not fused with the IF that filters their tuples:
+            // the body runs once per tuple from the iteration loop in exec.cpp,
+            // so the test at the start of the body is fused here instead
+            const utils::byte fused(fused_test_if(d.op));
+
+            if(fused && next.op == IF_INSTR && next.reg1 == d.reg3)
+               d.exec_op = fused;
+         }
+         break;
+      }
+   }
+}
+
+decoded_code::decoded_code(const byte_code code, const code_size_t size, program *prog)
+{
+   // map byte code offsets to instructions
+   vector<int> index(size, -1);
+   size_t total(0);
+
+   for(pcounter pc(code); pc < code + size; pc = advance(pc))
+      index[pc - code] = total++;
+
+   instrs.resize(total + 1);
+
+   for(pcounter pc(code); pc < code + size; pc = advance(pc)) {
+      decoded_instr& d(instrs[index[pc - code]]);
+
+      d.pc = pc;
+      d.op = d.exec_op = fetch(pc);
+      d.jump = NULL;
+      d.pred = NULL;
+      d.uint_value = 0;
+      d.reg1 = d.reg2 = d.reg3 = 0;
+      d.field1 = d.field2 = 0;
+
+      decode_instr(d, code, index, prog);
+   }
+
+   decoded_instr& end(instrs.back());
+
+   end.pc = code + size;
+   end.op = end.exec_op = DECODED_END_INSTR;
+   end.jump = NULL;
+   end.pred = NULL;
+
+   fuse();
+
+   for(size_t i(0); i < instrs.size(); ++i)
+      instrs[i].handler = decoded_handler(instrs[i].exec_op);
+}
+
+decoded_code::~decoded_code(void)
+{
+   for(size_t i(0); i < instrs.size(); ++i) {
+      if(instrs[i].op == SELECT_INSTR)
+         delete []instrs[i].targets;
+   }
+}
+
+}
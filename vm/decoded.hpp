@@ -0,0 +1,90 @@
+
+#ifndef VM_DECODED_HPP
+#define VM_DECODED_HPP
+
+#include <vector>
+
+#include "conf.hpp"
+#include "vm/defs.hpp"
+#include "vm/instr.hpp"
+
+namespace vm
+{
+
+class function;
+
+// instruction of the pre-decoded code (see program::decode_bytecode)
+// the operands of the most used instructions are read at load time,
+// the other instructions still read them from the original byte code
+struct decoded_instr {
+   void *handler; // label in the decoded interpreter (computed gotos)
+   pcounter pc; // original instruction
+   const decoded_instr *jump; // jump target
+   union {
+      predicate *pred;
+      function *fun;
+      const decoded_instr **targets; // select targets by node id
+   };
+   union {
+      int_val int_value;
+      uint_val uint_value;
+      float_val float_value;
+   };
+   utils::byte op; // original instruction
+   utils::byte exec_op; // instruction dispatched (op or a superinstruction)
+   reg_num reg1, reg2, reg3;
+   field_num field1, field2;
+};
+
+// opcode of the instruction placed after the last instruction of the code
+const utils::byte DECODED_END_INSTR = 0xFF;
+
+// superinstructions, only found in decoded code (see decoded_code::fuse)
+// they use the operands of the fused instructions, that remain in place
+enum fused_instr_type {
+   FUSED_MVFIELDFIELD2_INSTR = 0xE0, // MVFIELDFIELD, MVFIELDFIELD
+   FUSED_MVFIELDREG2_INSTR, // MVFIELDREG, MVFIELDREG
+   FUSED_ALLOC_SEND_INSTR, // ALLOC, uint_value field moves, SEND or ADDLINEAR
+   // comparison followed by an IF on the result
+   FUSED_INTLESSER_IF_INSTR,
+   FUSED_INTLESSEREQUAL_IF_INSTR,
+   FUSED_INTGREATER_IF_INSTR,
+   FUSED_INTGREATEREQUAL_IF_INSTR,
+   FUSED_FLOATEQUAL_IF_INSTR,
+   FUSED_FLOATNOTEQUAL_IF_INSTR,
+   FUSED_FLOATLESSER_IF_INSTR,
+   FUSED_FLOATLESSEREQUAL_IF_INSTR,
+   FUSED_FLOATGREATER_IF_INSTR,
+   FUSED_FLOATGREATEREQUAL_IF_INSTR,
+   FUSED_ADDREQUAL_IF_INSTR,
+   FUSED_ADDRNOTEQUAL_IF_INSTR,
+   FUSED_END_INSTR
+};
+
+const utils::byte FUSED_FIRST_INSTR = FUSED_MVFIELDFIELD2_INSTR;
+
+// returns the address of the handler for an opcode
+void *decoded_handler(const utils::byte);
+
+class decoded_code
+{
+private:
+
+   std::vector<decoded_instr> instrs;
+
+   const decoded_instr *find(const byte_code, const std::vector<int>&, const pcounter) const;
+   void decode_instr(decoded_instr&, const byte_code, const std::vector<int>&, program *);
+   void fuse(void);
+
+public:
+
+   inline const decoded_instr *get_first(void) const { return &instrs[0]; }
+
+   explicit decoded_code(const byte_code, const code_size_t, program *);
+
+   ~decoded_code(void);
+};
+
+}
+
+#endif
@@ -8,6 +8,7 @@
 #include "vm/exec.hpp"
 #include "vm/tuple.hpp"
 #include "vm/match.hpp"
+#include "vm/decoded.hpp"
 #include "db/tuple.hpp"
 #include "process/machine.hpp"
 #include "sched/nodes/thread_intrusive.hpp"
@@ -53,6 +54,7 @@ enum return_type {
 };
 
 static inline return_type execute(pcounter, state&, const reg_num, tuple*, predicate*);
+static inline return_type execute(const decoded_instr*, state&, const reg_num, tuple*, predicate*);
 
 static inline node_val
 get_node_val(pcounter& m, state& state)
@@ -82,17 +84,21 @@ get_tuple_field(state& state, const pcounter& pc)
 }
 
 static inline void
-execute_alloc(const pcounter& pc, state& state)
+execute_alloc(predicate *pred, const reg_num reg, state& state)
 {
-   predicate *pred(theProgram->get_predicate(alloc_predicate(pc)));
    tuple *tuple(vm::tuple::create(pred));
-   const reg_num reg(alloc_reg(pc));
 
    state.preds[reg] = pred;
 
    state.set_tuple(reg, tuple);
 }
 
+static inline void
+execute_alloc(const pcounter& pc, state& state)
+{
+   execute_alloc(theProgram->get_predicate(alloc_predicate(pc)), alloc_reg(pc), state);
+}
+
 static inline void
 execute_add_linear0(tuple *tuple, predicate *pred, state& state)
 {
@@ -104,9 +110,8 @@ execute_add_linear0(tuple *tuple, predicate *pred, state& state)
 }
 
 static inline void
-execute_add_linear(pcounter& pc, state& state)
+execute_add_linear(const reg_num r, state& state)
 {
-   const reg_num r(pcounter_reg(pc + instr_size));
    predicate *pred(state.preds[r]);
    tuple *tuple(state.get_tuple(r));
    assert(!pred->is_reused_pred());
@@ -127,6 +132,12 @@ execute_add_linear(pcounter& pc, state& state)
    execute_add_linear0(tuple, pred, state);
 }
 
+static inline void
+execute_add_linear(pcounter& pc, state& state)
+{
+   execute_add_linear(pcounter_reg(pc + instr_size), state);
+}
+
 static inline void
 execute_add_persistent0(tuple *tpl, predicate *pred, state& state)
 {
@@ -155,14 +166,18 @@ execute_add_persistent0(tuple *tpl, predicate *pred, state& state)
 }
 
 static inline void
-execute_add_persistent(pcounter& pc, state& state)
+execute_add_persistent(const reg_num r, state& state)
 {
-   const reg_num r(pcounter_reg(pc + instr_size));
-
    // tuple is either persistent or linear reused
    execute_add_persistent0(state.get_tuple(r), state.preds[r], state);
 }
 
+static inline void
+execute_add_persistent(pcounter& pc, state& state)
+{
+   execute_add_persistent(pcounter_reg(pc + instr_size), state);
+}
+
 static inline void
 execute_run_action0(tuple *tpl, predicate *pred, state& state)
 {
@@ -174,12 +189,17 @@ execute_run_action0(tuple *tpl, predicate *pred, state& state)
 }
 
 static inline void
-execute_run_action(pcounter& pc, state& state)
+execute_run_action(const reg_num r, state& state)
 {
-   const reg_num r(pcounter_reg(pc + instr_size));
    execute_run_action0(state.get_tuple(r), state.preds[r], state);
 }
 
+static inline void
+execute_run_action(pcounter& pc, state& state)
+{
+   execute_run_action(pcounter_reg(pc + instr_size), state);
+}
+
 static inline void
 execute_enqueue_linear0(tuple *tuple, predicate *pred, state& state)
 {
@@ -200,18 +220,20 @@ execute_enqueue_linear0(tuple *tuple, predicate *pred, state& state)
 }
 
 static inline void
-execute_enqueue_linear(pcounter& pc, state& state)
+execute_enqueue_linear(const reg_num r, state& state)
 {
-   const reg_num r(pcounter_reg(pc + instr_size));
-
    execute_enqueue_linear0(state.get_tuple(r), state.preds[r], state);
 }
 
 static inline void
-execute_send(const pcounter& pc, state& state)
+execute_enqueue_linear(pcounter& pc, state& state)
+{
+   execute_enqueue_linear(pcounter_reg(pc + instr_size), state);
+}
+
+static inline void
+execute_send(const reg_num msg, const reg_num dest, state& state)
 {
-   const reg_num msg(send_msg(pc));
-   const reg_num dest(send_dest(pc));
    const node_val dest_val(state.get_node(dest));
    predicate *pred(state.preds[msg]);
    tuple *tuple(state.get_tuple(msg));
@@ -259,13 +281,27 @@ execute_send(const pcounter& pc, state& state)
          execute_enqueue_linear0(tuple, pred, state);
       }
    } else {
-      All->MACHINE->route(state.node, state.sched, (node::node_id)dest_val, tuple, pred, state.count, state.depth);
+#ifdef USE_REAL_NODES
+      db::node *dest_node((db::node*)dest_val);
+#else
+      db::node *dest_node(All->DATABASE->find_node((node::node_id)dest_val));
+#endif
+
+      // nodes of this thread take the tuple without going through the router
+      if(pred->is_action_pred() || !state.sched->take_local_work(dest_node, tuple, pred, state.count, state.depth))
+         All->MACHINE->route(state.node, state.sched, (node::node_id)dest_val, tuple, pred, state.count, state.depth);
 #ifdef INSTRUMENTATION
       state.instr_facts_derived++;
 #endif
    }
 }
 
+static inline void
+execute_send(const pcounter& pc, state& state)
+{
+   execute_send(send_msg(pc), send_dest(pc), state);
+}
+
 static inline void
 execute_send_delay(const pcounter& pc, state& state)
 {
@@ -302,14 +338,17 @@ execute_send_delay(const pcounter& pc, state& state)
 }
 
 static inline void
-execute_not(pcounter& pc, state& state)
+execute_not(const reg_num op, const reg_num dest, state& state)
 {
-   const reg_num op(not_op(pc));
-   const reg_num dest(not_dest(pc));
-
    state.set_bool(dest, !state.get_bool(op));
 }
 
+static inline void
+execute_not(pcounter& pc, state& state)
+{
+   execute_not(not_op(pc), not_dest(pc), state);
+}
+
 static inline bool
 do_match(predicate *pred, const tuple *tuple, const field_num& field, const instr_val& val,
    pcounter &pc, const state& state)
@@ -662,10 +701,13 @@ public:
 static inline match*
 retrieve_match_object(state& state, pcounter pc, const predicate *pred, const size_t base)
 {
-   utils::byte *mdata((utils::byte*)iter_match_object(pc));
+   const size_t id(iter_match_id(pc));
+   utils::byte *mdata((utils::byte*)theProgram->get_iter_match(id));
    match *mobj(NULL);
 
    if(mdata == NULL) {
+      // the match objects of the instruction (one per thread) are built once,
+      // later executions only update the fields that depend on registers
       const size_t size = All->NUM_THREADS;
       const size_t matches = iter_matches_size(pc, base);
       const size_t var_size = count_variable_match_elements(pc + base, pred, matches);
@@ -676,10 +718,19 @@ retrieve_match_object(state& state, pcounter pc, const predicate *pred, const si
          m->init(pred, var_size);
          build_match_object(m, pc + base, pred, state, matches);
       }
-      state.matches_created.push_back((match*)mdata);
-      iter_match_object_set(pc, (ptr_val)mdata);
-      mobj = (match*)(mdata + mem * state.sched->get_id());
-   } else {
+      if(theProgram->install_iter_match(id, (ptr_val)mdata)) {
+         state.matches_created.push_back((match*)mdata);
+         mobj = (match*)(mdata + mem * state.sched->get_id());
+      } else {
+         // another thread built them first, use those instead
+         for(size_t i(0); i < size; ++i)
+            ((match*)(mdata + mem * i))->destroy();
+         mem::allocator<utils::byte>().deallocate(mdata, size * mem);
+         mdata = (utils::byte*)theProgram->get_iter_match(id);
+      }
+   }
+
+   if(mobj == NULL) {
       match *m((match*)mdata);
       mobj = (match*)(mdata + m->mem_size() * state.sched->get_id());
       if(!iter_constant_match(pc)) {
@@ -706,6 +757,36 @@ retrieve_match_object(state& state, pcounter pc, const predicate *pred, const si
    return mobj;
 }
 
+#ifdef TRIE_FILTERS
+// true if the node filter proves that no persistent tuple matches m
+static inline bool
+filter_rejects(const match *m, state& state, predicate *pred)
+{
+   if(state.node->may_match(pred->get_id(), m)) {
+#ifdef CORE_STATISTICS
+      if(m->has_match(0) && tuple_filter::usable(pred))
+         state.stat.stat_filter_passed++;
+#endif
+      return false;
+   }
+#ifdef CORE_STATISTICS
+   state.stat.stat_filter_rejects++;
+#endif
+   return true;
+}
+
+#ifdef CORE_STATISTICS
+// the filter let through a search that found nothing (counts only searches without tuples at all)
+#define COUNT_FILTER_EMPTY(IT)                                 \
+   if((IT) == tuple_trie::match_end() && m->has_match(0) && tuple_filter::usable(pred)) \
+      state.stat.stat_filter_false_positives++
+#else
+#define COUNT_FILTER_EMPTY(IT)
+#endif
+#else
+#define COUNT_FILTER_EMPTY(IT)
+#endif
+
 // iterate macros
 #define PUSH_CURRENT_STATE(TUPLE, TUPLE_LEAF, TUPLE_QUEUE, NEW_DEPTH)		\
 	state.is_linear = this_is_linear || state.is_linear;                    \
@@ -715,14 +796,21 @@ retrieve_match_object(state& state, pcounter pc, const predicate *pred, const si
    state.depth = old_depth
 #define TO_FINISH(ret) ((ret) == RETURN_LINEAR || (ret) == RETURN_DERIVED)
 
+template <typename CODE>
 static inline return_type
-execute_pers_iter(const reg_num reg, match* m, const pcounter first, state& state, predicate *pred)
+execute_pers_iter(const reg_num reg, match* m, const CODE first, state& state, predicate *pred)
 {
    const depth_t old_depth(state.depth);
    const bool old_is_linear(state.is_linear);
    const bool this_is_linear(false);
 
+#ifdef TRIE_FILTERS
+   if(filter_rejects(m, state, pred))
+      return RETURN_NO_RETURN;
+#endif
+
    tuple_trie::tuple_search_iterator tuples_it = state.node->match_predicate(pred->get_id(), m);
+   COUNT_FILTER_EMPTY(tuples_it);
    for(tuple_trie::tuple_search_iterator end(tuple_trie::match_end());
          tuples_it != end;
          ++tuples_it)
@@ -756,8 +844,9 @@ execute_pers_iter(const reg_num reg, match* m, const pcounter first, state& stat
    return RETURN_NO_RETURN;
 }
 
+template <typename CODE>
 static inline return_type
-execute_olinear_iter(const reg_num reg, match* m, const pcounter pc, const pcounter first, state& state, predicate *pred)
+execute_olinear_iter(const reg_num reg, match* m, const pcounter pc, const CODE first, state& state, predicate *pred)
 {
    const depth_t old_depth(state.depth);
    const bool old_is_linear(state.is_linear);
@@ -836,8 +925,9 @@ next_tuple:
    return RETURN_NO_RETURN;
 }
 
+template <typename CODE>
 static inline return_type
-execute_orlinear_iter(const reg_num reg, match* m, const pcounter pc, const pcounter first, state& state, predicate *pred)
+execute_orlinear_iter(const reg_num reg, match* m, const pcounter pc, const CODE first, state& state, predicate *pred)
 {
    const depth_t old_depth(state.depth);
    const bool old_is_linear(state.is_linear);
@@ -911,8 +1001,9 @@ next_tuple:
    return RETURN_NO_RETURN;
 }
 
+template <typename CODE>
 static inline return_type
-execute_opers_iter(const reg_num reg, match* m, const pcounter pc, const pcounter first, state& state, predicate *pred)
+execute_opers_iter(const reg_num reg, match* m, const pcounter pc, const CODE first, state& state, predicate *pred)
 {
    const depth_t old_depth(state.depth);
    const bool old_is_linear(state.is_linear);
@@ -923,7 +1014,13 @@ execute_opers_iter(const reg_num reg, match* m, const pcounter pc, const pcounte
    typedef vector<tuple_trie_leaf*, mem::allocator<tuple_trie_leaf*> > vector_leaves;
    vector_leaves leaves;
 
+#ifdef TRIE_FILTERS
+   if(filter_rejects(m, state, pred))
+      return RETURN_NO_RETURN;
+#endif
+
    tuple_trie::tuple_search_iterator tuples_it = state.node->match_predicate(pred->get_id(), m);
+   COUNT_FILTER_EMPTY(tuples_it);
 
    for(tuple_trie::tuple_search_iterator end(tuple_trie::match_end());
          tuples_it != end; ++tuples_it)
@@ -968,8 +1065,9 @@ execute_opers_iter(const reg_num reg, match* m, const pcounter pc, const pcounte
    return RETURN_NO_RETURN;
 }
 
+template <typename CODE>
 static inline return_type
-execute_linear_iter_list(const reg_num reg, match* m, const pcounter first, state& state, predicate* pred, db::intrusive_list<vm::tuple> *local_tuples, hash_table *tbl = NULL)
+execute_linear_iter_list(const reg_num reg, match* m, const CODE first, state& state, predicate* pred, db::intrusive_list<vm::tuple> *local_tuples, hash_table *tbl = NULL)
 {
    if(local_tuples == NULL)
       return RETURN_NO_RETURN;
@@ -1053,11 +1151,42 @@ execute_linear_iter_list(const reg_num reg, match* m, const pcounter first, stat
    return RETURN_NO_RETURN;
 }
 
+// picks the smallest set of buckets that may contain tuples matching the match object
+static inline hash_table::iterator
+select_buckets(match *m, hash_table *table)
+{
+   const field_num hashed(table->get_hash_argument());
+
+   if(table->is_composite()) {
+      const field_num hashed2(table->get_second_hash_argument());
+
+      if(m->has_match(hashed)) {
+         const match_field mf(m->get_match(hashed));
+         if(m->has_match(hashed2)) {
+            const match_field mf2(m->get_match(hashed2));
+            db::intrusive_list<vm::tuple> *bucket(table->lookup_list(mf.field, mf2.field));
+            return hash_table::iterator(bucket, bucket + 1);
+         }
+         return table->lookup_first(mf.field);
+      } else if(m->has_match(hashed2)) {
+         const match_field mf2(m->get_match(hashed2));
+         return table->lookup_second(mf2.field);
+      }
+   } else if(m->has_match(hashed)) {
+      const match_field mf(m->get_match(hashed));
+      db::intrusive_list<vm::tuple> *bucket(table->lookup_list(mf.field));
+      return hash_table::iterator(bucket, bucket + 1);
+   }
+
+   // go through hash table
+   return table->begin();
+}
+
+template <typename CODE>
 static inline return_type
-execute_linear_iter(const reg_num reg, match* m, const pcounter first, state& state, predicate *pred)
+execute_linear_iter(const reg_num reg, match* m, const CODE first, state& state, predicate *pred)
 {
    if(state.lstore->stored_as_hash_table(pred)) {
-      const field_num hashed(pred->get_hashed_field());
       hash_table *table(state.lstore->get_hash_table(pred->get_id()));
 
       if(table == NULL)
@@ -1068,21 +1197,13 @@ execute_linear_iter(const reg_num reg, match* m, const pcounter first, state& st
       table->dump(cout, pred);
 #endif
 
-      if(m->has_match(hashed)) {
-         const match_field mf(m->get_match(hashed));
-         db::intrusive_list<vm::tuple> *local_tuples(table->lookup_list(mf.field));
+      for(hash_table::iterator it(select_buckets(m, table)); !it.end(); ++it) {
+         db::intrusive_list<vm::tuple> *local_tuples(*it);
          return_type ret(execute_linear_iter_list(reg, m, first, state, pred, local_tuples, table));
-         return ret;
-      } else {
-         // go through hash table
-         for(hash_table::iterator it(table->begin()); !it.end(); ++it) {
-            db::intrusive_list<vm::tuple> *local_tuples(*it);
-            return_type ret(execute_linear_iter_list(reg, m, first, state, pred, local_tuples, table));
-            if(ret != RETURN_NO_RETURN)
-               return ret;
-         }
-         return RETURN_NO_RETURN;
+         if(ret != RETURN_NO_RETURN)
+            return ret;
       }
+      return RETURN_NO_RETURN;
    } else {
       db::intrusive_list<vm::tuple> *local_tuples(state.lstore->get_linked_list(pred->get_id()));
       return execute_linear_iter_list(reg, m, first, state, pred, local_tuples);
@@ -1091,8 +1212,9 @@ execute_linear_iter(const reg_num reg, match* m, const pcounter first, state& st
    return RETURN_NO_RETURN;
 }
 
+template <typename CODE>
 static inline return_type
-execute_rlinear_iter_list(const reg_num reg, match* m, const pcounter first, state& state, predicate *pred, db::intrusive_list<vm::tuple> *local_tuples)
+execute_rlinear_iter_list(const reg_num reg, match* m, const CODE first, state& state, predicate *pred, db::intrusive_list<vm::tuple> *local_tuples)
 {
    const bool old_is_linear(state.is_linear);
    const bool this_is_linear(false);
@@ -1133,28 +1255,20 @@ execute_rlinear_iter_list(const reg_num reg, match* m, const pcounter first, sta
    return RETURN_NO_RETURN;
 }
 
+template <typename CODE>
 static inline return_type
-execute_rlinear_iter(const reg_num reg, match* m, const pcounter first, state& state, predicate *pred)
+execute_rlinear_iter(const reg_num reg, match* m, const CODE first, state& state, predicate *pred)
 {
    if(state.lstore->stored_as_hash_table(pred)) {
-      const field_num hashed(pred->get_hashed_field());
       hash_table *table(state.lstore->get_hash_table(pred->get_id()));
 
-      if(m->has_match(hashed)) {
-         const match_field mf(m->get_match(hashed));
-         db::intrusive_list<vm::tuple> *local_tuples(table->lookup_list(mf.field));
+      for(hash_table::iterator it(select_buckets(m, table)); !it.end(); ++it) {
+         db::intrusive_list<vm::tuple> *local_tuples(*it);
          return_type ret(execute_rlinear_iter_list(reg, m, first, state, pred, local_tuples));
-         return ret;
-      } else {
-         // go through hash table
-         for(hash_table::iterator it(table->begin()); !it.end(); ++it) {
-            db::intrusive_list<vm::tuple> *local_tuples(*it);
-            return_type ret(execute_rlinear_iter_list(reg, m, first, state, pred, local_tuples));
-            if(ret != RETURN_NO_RETURN)
-               return ret;
-         }
-         return RETURN_NO_RETURN;
+         if(ret != RETURN_NO_RETURN)
+            return ret;
       }
+      return RETURN_NO_RETURN;
    } else {
       db::intrusive_list<vm::tuple> *local_tuples(state.lstore->get_linked_list(pred->get_id()));
       return execute_rlinear_iter_list(reg, m, first, state, pred, local_tuples);
@@ -1162,25 +1276,31 @@ execute_rlinear_iter(const reg_num reg, match* m, const pcounter first, state& s
 }
 
 static inline void
-execute_testnil(pcounter pc, state& state)
+execute_testnil(const reg_num op, const reg_num dest, state& state)
 {
-   const reg_num op(test_nil_op(pc));
-   const reg_num dest(test_nil_dest(pc));
-
    runtime::cons *x(state.get_cons(op));
 
    state.set_bool(dest, runtime::cons::is_null(x));
 }
 
 static inline void
-execute_float(pcounter& pc, state& state)
+execute_testnil(pcounter pc, state& state)
 {
-   const reg_num src(pcounter_reg(pc + instr_size));
-   const reg_num dst(pcounter_reg(pc + instr_size + reg_val_size));
+   execute_testnil(test_nil_op(pc), test_nil_dest(pc), state);
+}
 
+static inline void
+execute_float(const reg_num src, const reg_num dst, state& state)
+{
    state.set_float(dst, static_cast<float_val>(state.get_int(src)));
 }
 
+static inline void
+execute_float(pcounter& pc, state& state)
+{
+   execute_float(pcounter_reg(pc + instr_size), pcounter_reg(pc + instr_size + reg_val_size), state);
+}
+
 static inline pcounter
 execute_select(pcounter pc, state& state)
 {
@@ -1240,9 +1360,8 @@ execute_delete(const pcounter pc, state& state)
 #endif
 
 static inline void
-execute_remove(pcounter pc, state& state)
+execute_remove(const reg_num reg, state& state)
 {
-   const reg_num reg(pcounter_reg(pc + instr_size));
    vm::tuple *tpl(state.get_tuple(reg));
    vm::predicate *pred(state.preds[reg]);
 
@@ -1278,9 +1397,14 @@ execute_remove(pcounter pc, state& state)
 }
 
 static inline void
-execute_update(pcounter pc, state& state)
+execute_remove(pcounter pc, state& state)
+{
+   execute_remove(pcounter_reg(pc + instr_size), state);
+}
+
+static inline void
+execute_update(const reg_num reg, state& state)
 {
-   const reg_num reg(pcounter_reg(pc + instr_size));
    vm::tuple *tpl(state.get_tuple(reg));
    vm::predicate *pred(state.preds[reg]);
 
@@ -1293,6 +1417,12 @@ execute_update(pcounter pc, state& state)
    state.store->matcher.mark(pred);
 }
 
+static inline void
+execute_update(pcounter pc, state& state)
+{
+   execute_update(pcounter_reg(pc + instr_size), state);
+}
+
 static inline void
 set_call_return(const reg_num reg, const tuple_field ret, external_function* f, state& state)
 {
@@ -1446,12 +1576,21 @@ execute_calle(pcounter pc, state& state)
    set_call_return(calle_dest(pc), do_call(f, args), f, state);
 }
 
+// programs with integer priorities keep them in int registers
+static inline float_val
+get_priority_value(const reg_num reg, state& state)
+{
+   if(theProgram->get_priority_type() == FIELD_INT)
+      return (float_val)state.get_int(reg);
+   return state.get_float(reg);
+}
+
 static inline void
 execute_set_priority(pcounter& pc, state& state)
 {
    const reg_num prio_reg(pcounter_reg(pc + instr_size));
    const reg_num node_reg(pcounter_reg(pc + instr_size + reg_val_size));
-   const float_val prio(state.get_float(prio_reg));
+   const float_val prio(get_priority_value(prio_reg, state));
    const node_val node(state.get_node(node_reg));
 
 #ifdef USE_REAL_NODES
@@ -1465,7 +1604,7 @@ static inline void
 execute_set_priority_here(pcounter& pc, state& state)
 {
    const reg_num prio_reg(pcounter_reg(pc + instr_size));
-   const float_val prio(state.get_float(prio_reg));
+   const float_val prio(get_priority_value(prio_reg, state));
 
    state.sched->set_node_priority(state.node, prio);
 }
@@ -1475,7 +1614,7 @@ execute_add_priority(pcounter& pc, state& state)
 {
    const reg_num prio_reg(pcounter_reg(pc + instr_size));
    const reg_num node_reg(pcounter_reg(pc + instr_size + reg_val_size));
-   const float_val prio(state.get_float(prio_reg));
+   const float_val prio(get_priority_value(prio_reg, state));
    const node_val node(state.get_node(node_reg));
 
 #ifdef USE_REAL_NODES
@@ -1489,7 +1628,7 @@ static inline void
 execute_add_priority_here(pcounter& pc, state& state)
 {
    const reg_num prio_reg(pcounter_reg(pc + instr_size));
-   const float_val prio(state.get_float(prio_reg));
+   const float_val prio(get_priority_value(prio_reg, state));
 
    state.sched->add_node_priority(state.node, prio);
 }
@@ -1522,14 +1661,15 @@ execute_node_priority(pcounter& pc, state& state)
 #endif
 
    sched::thread_intrusive_node *tn((sched::thread_intrusive_node *)node);
-   state.set_float(dest_reg, tn->get_float_priority_level());
+   if(theProgram->get_priority_type() == FIELD_INT)
+      state.set_int(dest_reg, tn->get_int_priority_level());
+   else
+      state.set_float(dest_reg, tn->get_float_priority_level());
 }
 
 static inline void
-execute_rule(const pcounter& pc, state& state)
+execute_rule_start(const size_t rule_id, state& state)
 {
-   const size_t rule_id(rule_get_id(pc));
-
    state.current_rule = rule_id;
 
 #ifdef USE_UI
@@ -1548,6 +1688,12 @@ execute_rule(const pcounter& pc, state& state)
 #endif
 }
 
+static inline void
+execute_rule(const pcounter& pc, state& state)
+{
+   execute_rule_start(rule_get_id(pc), state);
+}
+
 static inline void
 execute_rule_done(const pcounter& pc, state& state)
 {
@@ -2463,11 +2609,17 @@ execute_consfff(pcounter& pc, state& state)
    dest->set_cons(field_dest, new_list);
 }
 
+#ifdef OPCODE_PROFILING
+#define PROFILE_OPCODE(OP) state.opcodes.record(OP)
+#else
+#define PROFILE_OPCODE(OP)
+#endif
+
 #ifdef COMPUTED_GOTOS
 #define CASE(X)
 #define JUMP_NEXT() goto *jump_table[fetch(pc)]
-#define JUMP(label, jump_offset) label: { const pcounter npc = pc + jump_offset; register void *to_go = (void*)jump_table[fetch(npc)];
-#define COMPLEX_JUMP(label) label: {
+#define JUMP(label, jump_offset) label: { PROFILE_OPCODE(fetch(pc)); const pcounter npc = pc + jump_offset; register void *to_go = (void*)jump_table[fetch(npc)];
+#define COMPLEX_JUMP(label) label: { PROFILE_OPCODE(fetch(pc));
 #define ADVANCE() pc = npc; goto *to_go;
 #define ENDOP() }
 #else
@@ -2516,6 +2668,7 @@ eval_loop:
 #ifdef CORE_STATISTICS
 		state.stat.stat_instructions_executed++;
 #endif
+      PROFILE_OPCODE(fetch(pc));
 		
       switch(fetch(pc)) {
 #endif // !COMPUTED_GOTOS
@@ -3513,8 +3666,721 @@ eval_loop:
 #endif
 }
 
+// pre-decoded interpreter, used with the -X option
+// operands read at load time are taken from the decoded instruction,
+// the other instructions read them from the original byte code (ip->pc)
+
+#ifdef COMPUTED_GOTOS
+#define DECODED_CASE(X)
+#define DECODED_JUMP_NEXT() goto *ip->handler
+#define DECODED_JUMP(label) label: { PROFILE_OPCODE(ip->op); const decoded_instr *nip(ip + 1); register void *to_go(nip->handler);
+#define DECODED_COMPLEX_JUMP(label) label: { PROFILE_OPCODE(ip->op);
+#define DECODED_ADVANCE() ip = nip; goto *to_go;
+#else
+#define DECODED_CASE(INSTR) case INSTR:
+#define DECODED_JUMP_NEXT() goto decoded_loop
+#define DECODED_JUMP(label) { const decoded_instr *nip(ip + 1);
+#define DECODED_COMPLEX_JUMP(label) {
+#define DECODED_ADVANCE() ip = nip; DECODED_JUMP_NEXT();
+#endif
+
+#ifdef CORE_STATISTICS
+#define COUNT_MOVE() state.stat.stat_moves_executed++
+#else
+#define COUNT_MOVE()
+#endif
+
+// instruction that still reads its operands from the byte code
+#define DECODED_BYTECODE(INSTR, label, FUNCTION)   \
+   DECODED_CASE(INSTR)                             \
+      DECODED_JUMP(label)                          \
+      {                                            \
+         pcounter pc(ip->pc);                      \
+         FUNCTION(pc, state);                      \
+      }                                            \
+      DECODED_ADVANCE()                            \
+   ENDOP()
+#define DECODED_MOVE(INSTR, label, FUNCTION)       \
+   DECODED_CASE(INSTR)                             \
+      DECODED_JUMP(label)                          \
+      COUNT_MOVE();                                \
+      {                                            \
+         pcounter pc(ip->pc);                      \
+         FUNCTION(pc, state);                      \
+      }                                            \
+      DECODED_ADVANCE()                            \
+   ENDOP()
+#define DECODED_OPERATION(INSTR, label, SET_FUNCTION, GET_FUNCTION, OP)                            \
+   DECODED_CASE(INSTR)                                                                             \
+      DECODED_JUMP(label)                                                                          \
+      state.SET_FUNCTION(ip->reg3, state.GET_FUNCTION(ip->reg1) OP state.GET_FUNCTION(ip->reg2));  \
+      DECODED_ADVANCE()                                                                            \
+   ENDOP()
+#define DECODED_ITER(INSTR, label, BASE, ITERATE)                                   \
+   DECODED_CASE(INSTR)                                                              \
+      DECODED_COMPLEX_JUMP(label)                                                   \
+      {                                                                             \
+         match *mobj(retrieve_match_object(state, ip->pc, ip->pred, BASE));         \
+         const return_type ret(ITERATE);                                            \
+         if(ret == RETURN_LINEAR) return RETURN_LINEAR;                             \
+         if(ret == RETURN_DERIVED && state.is_linear) return RETURN_DERIVED;        \
+         ip = ip->jump;                                                             \
+         DECODED_JUMP_NEXT();                                                       \
+      }                                                                             \
+   ENDOP()
+
+#define DECODED_FUSED_TEST_IF(INSTR, label, GET_FUNCTION, OP)                               \
+   DECODED_CASE(INSTR)                                                                       \
+      DECODED_COMPLEX_JUMP(label)                                                            \
+      {                                                                                      \
+         const bool_val result(state.GET_FUNCTION(ip->reg1) OP state.GET_FUNCTION(ip->reg2)); \
+         state.set_bool(ip->reg3, result);                                                   \
+         COUNT_IF_TEST();                                                                    \
+         if(result)                                                                          \
+            ip += 2;                                                                         \
+         else {                                                                              \
+            COUNT_IF_FAILED();                                                               \
+            ip = (ip + 1)->jump;                                                             \
+         }                                                                                   \
+         DECODED_JUMP_NEXT();                                                                \
+      }                                                                                      \
+   ENDOP()
+
+#ifdef CORE_STATISTICS
+#define COUNT_IF_TEST() state.stat.stat_if_tests++
+#define COUNT_IF_FAILED() state.stat.stat_if_failed++
+#else
+#define COUNT_IF_TEST()
+#define COUNT_IF_FAILED()
+#endif
+
+static inline void
+decoded_mvfieldfield(const decoded_instr *ip, state& state)
+{
+   state.get_tuple(ip->reg2)->set_field(ip->field2, state.get_tuple(ip->reg1)->get_field(ip->field1));
+}
+
+static inline void
+decoded_mvfieldreg(const decoded_instr *ip, state& state)
+{
+   state.set_reg(ip->reg2, state.get_tuple(ip->reg1)->get_field(ip->field1));
+}
+
+static inline void
+decoded_mvregfield(const decoded_instr *ip, state& state)
+{
+   state.get_tuple(ip->reg2)->set_field(ip->field1, state.get_reg(ip->reg1));
+}
+
+static inline void
+decoded_mvhostfield(const decoded_instr *ip, state& state)
+{
+#ifdef USE_REAL_NODES
+   state.get_tuple(ip->reg1)->set_node(ip->field1, (node_val)state.node);
+#else
+   state.get_tuple(ip->reg1)->set_node(ip->field1, state.node->get_id());
+#endif
+}
+
+// moves fused after an ALLOC
+static inline void
+execute_decoded_move(const decoded_instr *ip, state& state)
+{
+#ifdef CORE_STATISTICS
+   state.stat.stat_moves_executed++;
+#endif
+   switch(ip->op) {
+      case MVFIELDFIELD_INSTR: decoded_mvfieldfield(ip, state); break;
+      case MVFIELDREG_INSTR: decoded_mvfieldreg(ip, state); break;
+      case MVREGFIELD_INSTR: decoded_mvregfield(ip, state); break;
+      case MVINTFIELD_INSTR: state.get_tuple(ip->reg1)->set_int(ip->field1, ip->int_value); break;
+      case MVFLOATFIELD_INSTR: state.get_tuple(ip->reg1)->set_float(ip->field1, ip->float_value); break;
+      case MVHOSTFIELD_INSTR: decoded_mvhostfield(ip, state); break;
+      default: assert(false);
+   }
+}
+
+#ifdef COMPUTED_GOTOS
+static void **decoded_jump_table(NULL);
+static void **decoded_fused_table(NULL);
+#endif
+
+static return_type
+execute_decoded(const decoded_instr *ip, state *st, const reg_num reg, tuple *tpl, predicate *pred)
+{
+#ifdef COMPUTED_GOTOS
+#include "vm/jump_table.hpp"
+   static void *fused_table[FUSED_END_INSTR - FUSED_FIRST_INSTR] = {&&fused_mvfieldfield2, &&fused_mvfieldreg2,
+      &&fused_alloc_send, &&fused_intlesser_if, &&fused_intlesserequal_if, &&fused_intgreater_if,
+      &&fused_intgreaterequal_if, &&fused_floatequal_if, &&fused_floatnotequal_if, &&fused_floatlesser_if,
+      &&fused_floatlesserequal_if, &&fused_floatgreater_if, &&fused_floatgreaterequal_if,
+      &&fused_addrequal_if, &&fused_addrnotequal_if};
+
+   if(ip == NULL) {
+      // called by decoded_handler()
+      decoded_jump_table = jump_table;
+      decoded_fused_table = fused_table;
+      return RETURN_OK;
+   }
+#endif
+
+   state& state(*st);
+
+	if(tpl != NULL) {
+      state.set_tuple(reg, tpl);
+      state.preds[reg] = pred;
+#ifdef CORE_STATISTICS
+		state.stat.stat_tuples_used++;
+      if(tpl->is_linear()) {
+         state.stat.stat_predicate_applications[pred->get_id()]++;
+      }
+#endif
+   }
+
+#ifdef COMPUTED_GOTOS
+   DECODED_JUMP_NEXT();
+#else
+   while(true)
+   {
+decoded_loop:
+
+#ifdef CORE_STATISTICS
+		state.stat.stat_instructions_executed++;
+#endif
+      PROFILE_OPCODE(ip->op);
+
+      switch(ip->exec_op) {
+#endif // !COMPUTED_GOTOS
+         DECODED_CASE(RETURN_INSTR)
+            DECODED_COMPLEX_JUMP(return_instr)
+            return RETURN_OK;
+         ENDOP()
+
+         DECODED_CASE(NEXT_INSTR)
+            DECODED_COMPLEX_JUMP(next_instr)
+            return RETURN_NEXT;
+         ENDOP()
+
+         DECODED_CASE(RETURN_LINEAR_INSTR)
+            DECODED_COMPLEX_JUMP(return_linear)
+            return RETURN_LINEAR;
+         ENDOP()
+
+         DECODED_CASE(RETURN_DERIVED_INSTR)
+            DECODED_COMPLEX_JUMP(return_derived)
+            return RETURN_DERIVED;
+         ENDOP()
+
+         DECODED_CASE(RETURN_SELECT_INSTR)
+            DECODED_COMPLEX_JUMP(return_select)
+            ip = ip->jump;
+            DECODED_JUMP_NEXT();
+         ENDOP()
+
+         DECODED_CASE(IF_INSTR)
+            DECODED_JUMP(if_instr)
+#ifdef CORE_STATISTICS
+				state.stat.stat_if_tests++;
+#endif
+            if(!state.get_bool(ip->reg1)) {
+#ifdef CORE_STATISTICS
+					state.stat.stat_if_failed++;
+#endif
+               ip = ip->jump;
+               DECODED_JUMP_NEXT();
+            }
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(IF_ELSE_INSTR)
+            DECODED_JUMP(if_else)
+#ifdef CORE_STATISTICS
+            state.stat.stat_if_tests++;
+#endif
+            if(!state.get_bool(ip->reg1)) {
+#ifdef CORE_STATISTICS
+               state.stat.stat_if_failed++;
+#endif
+               ip = ip->jump;
+               DECODED_JUMP_NEXT();
+            }
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(JUMP_INSTR)
+            DECODED_COMPLEX_JUMP(jump)
+            ip = ip->jump;
+            DECODED_JUMP_NEXT();
+         ENDOP()
+
+         DECODED_CASE(END_LINEAR_INSTR)
+            DECODED_COMPLEX_JUMP(end_linear)
+            return RETURN_END_LINEAR;
+         ENDOP()
+
+         DECODED_CASE(RESET_LINEAR_INSTR)
+            DECODED_COMPLEX_JUMP(reset_linear)
+            {
+               const bool old_is_linear(state.is_linear);
+
+               state.is_linear = false;
+
+               return_type ret(execute(ip + 1, state, 0, NULL, NULL));
+
+               assert(ret == RETURN_END_LINEAR);
+               (void)ret;
+
+               state.is_linear = old_is_linear;
+
+               ip = ip->jump;
+               DECODED_JUMP_NEXT();
+            }
+         ENDOP()
+
+         DECODED_ITER(PERS_ITER_INSTR, pers_iter, PERS_ITER_BASE,
+               execute_pers_iter(ip->reg1, mobj, ip + 1, state, ip->pred))
+         DECODED_ITER(LINEAR_ITER_INSTR, linear_iter, LINEAR_ITER_BASE,
+               execute_linear_iter(ip->reg1, mobj, ip + 1, state, ip->pred))
+         DECODED_ITER(RLINEAR_ITER_INSTR, rlinear_iter, RLINEAR_ITER_BASE,
+               execute_rlinear_iter(ip->reg1, mobj, ip + 1, state, ip->pred))
+         DECODED_ITER(OPERS_ITER_INSTR, opers_iter, OPERS_ITER_BASE,
+               execute_opers_iter(ip->reg1, mobj, ip->pc, ip + 1, state, ip->pred))
+         DECODED_ITER(OLINEAR_ITER_INSTR, olinear_iter, OLINEAR_ITER_BASE,
+               execute_olinear_iter(ip->reg1, mobj, ip->pc, ip + 1, state, ip->pred))
+         DECODED_ITER(ORLINEAR_ITER_INSTR, orlinear_iter, ORLINEAR_ITER_BASE,
+               execute_orlinear_iter(ip->reg1, mobj, ip->pc, ip + 1, state, ip->pred))
+
+         DECODED_CASE(REMOVE_INSTR)
+            DECODED_JUMP(remove)
+            execute_remove(ip->reg1, state);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(UPDATE_INSTR)
+            DECODED_JUMP(update)
+            execute_update(ip->reg1, state);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(ALLOC_INSTR)
+            DECODED_JUMP(alloc)
+            execute_alloc(ip->pred, ip->reg1, state);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(SEND_INSTR)
+            DECODED_JUMP(send)
+            execute_send(ip->reg1, ip->reg2, state);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(ADDLINEAR_INSTR)
+            DECODED_JUMP(addlinear)
+            execute_add_linear(ip->reg1, state);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(ADDPERS_INSTR)
+            DECODED_JUMP(addpers)
+            execute_add_persistent(ip->reg1, state);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(RUNACTION_INSTR)
+            DECODED_JUMP(runaction)
+            execute_run_action(ip->reg1, state);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(ENQUEUE_LINEAR_INSTR)
+            DECODED_JUMP(enqueue_linear)
+            execute_enqueue_linear(ip->reg1, state);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_BYTECODE(SEND_DELAY_INSTR, send_delay, execute_send_delay)
+
+         DECODED_CASE(NOT_INSTR)
+            DECODED_JUMP(not_instr)
+            execute_not(ip->reg1, ip->reg2, state);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(TESTNIL_INSTR)
+            DECODED_JUMP(testnil)
+            execute_testnil(ip->reg1, ip->reg2, state);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(FLOAT_INSTR)
+            DECODED_JUMP(float_instr)
+            execute_float(ip->reg1, ip->reg2, state);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(SELECT_INSTR)
+            DECODED_COMPLEX_JUMP(select)
+            {
+               const node::node_id id(state.node->get_id());
+
+               if(id > All->DATABASE->static_max_id() || id >= ip->uint_value)
+                  ip = ip->jump;
+               else
+                  ip = ip->targets[id];
+               DECODED_JUMP_NEXT();
+            }
+         ENDOP()
+
+         DECODED_CASE(DELETE_INSTR)
+            DECODED_JUMP(delete_instr)
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_BYTECODE(CALL_INSTR, call, execute_call)
+         DECODED_BYTECODE(CALL0_INSTR, call0, execute_call0)
+         DECODED_BYTECODE(CALL1_INSTR, call1, execute_call1)
+         DECODED_BYTECODE(CALL2_INSTR, call2, execute_call2)
+         DECODED_BYTECODE(CALL3_INSTR, call3, execute_call3)
+
+         DECODED_CASE(RULE_INSTR)
+            DECODED_JUMP(rule)
+            execute_rule_start(ip->uint_value, state);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_BYTECODE(RULE_DONE_INSTR, rule_done, execute_rule_done)
+         DECODED_BYTECODE(NEW_NODE_INSTR, new_node, execute_new_node)
+         DECODED_BYTECODE(NEW_AXIOMS_INSTR, new_axioms, execute_new_axioms)
+
+         DECODED_CASE(PUSH_INSTR)
+            DECODED_JUMP(push)
+            state.stack.push();
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(PUSHN_INSTR)
+            DECODED_JUMP(pushn)
+            state.stack.push(ip->uint_value);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(POP_INSTR)
+            DECODED_JUMP(pop)
+            state.stack.pop();
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(PUSH_REGS_INSTR)
+            DECODED_JUMP(push_regs)
+            state.stack.push_regs(state.regs);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(POP_REGS_INSTR)
+            DECODED_JUMP(pop_regs)
+            state.stack.pop_regs(state.regs);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(CALLF_INSTR)
+            DECODED_COMPLEX_JUMP(callf)
+            ip = ip->fun->get_decoded();
+            DECODED_JUMP_NEXT();
+         ENDOP()
+
+         DECODED_BYTECODE(MAKE_STRUCTR_INSTR, make_structr, execute_make_structr)
+         DECODED_BYTECODE(MAKE_STRUCTF_INSTR, make_structf, execute_make_structf)
+         DECODED_BYTECODE(STRUCT_VALRR_INSTR, struct_valrr, execute_struct_valrr)
+         DECODED_BYTECODE(STRUCT_VALFR_INSTR, struct_valfr, execute_struct_valfr)
+         DECODED_BYTECODE(STRUCT_VALRF_INSTR, struct_valrf, execute_struct_valrf)
+         DECODED_BYTECODE(STRUCT_VALRFR_INSTR, struct_valrfr, execute_struct_valrfr)
+         DECODED_BYTECODE(STRUCT_VALFF_INSTR, struct_valff, execute_struct_valff)
+         DECODED_BYTECODE(STRUCT_VALFFR_INSTR, struct_valffr, execute_struct_valffr)
+
+         DECODED_CASE(MVINTFIELD_INSTR)
+            DECODED_JUMP(mvintfield)
+            COUNT_MOVE();
+            state.get_tuple(ip->reg1)->set_int(ip->field1, ip->int_value);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(MVINTREG_INSTR)
+            DECODED_JUMP(mvintreg)
+            COUNT_MOVE();
+            state.set_int(ip->reg1, ip->int_value);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(MVFIELDFIELD_INSTR)
+            DECODED_JUMP(mvfieldfield)
+            COUNT_MOVE();
+            decoded_mvfieldfield(ip, state);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_MOVE(MVFIELDFIELDR_INSTR, mvfieldfieldr, execute_mvfieldfieldr)
+
+         DECODED_CASE(MVFIELDREG_INSTR)
+            DECODED_JUMP(mvfieldreg)
+            COUNT_MOVE();
+            decoded_mvfieldreg(ip, state);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_MOVE(MVPTRREG_INSTR, mvptrreg, execute_mvptrreg)
+         DECODED_MOVE(MVNILFIELD_INSTR, mvnilfield, execute_mvnilfield)
+
+         DECODED_CASE(MVNILREG_INSTR)
+            DECODED_JUMP(mvnilreg)
+            COUNT_MOVE();
+            state.set_nil(ip->reg1);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(MVREGFIELD_INSTR)
+            DECODED_JUMP(mvregfield)
+            COUNT_MOVE();
+            decoded_mvregfield(ip, state);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_MOVE(MVREGFIELDR_INSTR, mvregfieldr, execute_mvregfieldr)
+
+         DECODED_CASE(MVHOSTFIELD_INSTR)
+            DECODED_JUMP(mvhostfield)
+            COUNT_MOVE();
+            decoded_mvhostfield(ip, state);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_MOVE(MVREGCONST_INSTR, mvregconst, execute_mvregconst)
+         DECODED_MOVE(MVCONSTFIELD_INSTR, mvconstfield, execute_mvconstfield)
+         DECODED_MOVE(MVCONSTFIELDR_INSTR, mvconstfieldr, execute_mvconstfieldr)
+         DECODED_MOVE(MVADDRFIELD_INSTR, mvaddrfield, execute_mvaddrfield)
+
+         DECODED_CASE(MVFLOATFIELD_INSTR)
+            DECODED_JUMP(mvfloatfield)
+            COUNT_MOVE();
+            state.get_tuple(ip->reg1)->set_float(ip->field1, ip->float_value);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(MVFLOATREG_INSTR)
+            DECODED_JUMP(mvfloatreg)
+            COUNT_MOVE();
+            state.set_float(ip->reg1, ip->float_value);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_CASE(MVINTCONST_INSTR)
+            DECODED_JUMP(mvintconst)
+            COUNT_MOVE();
+            {
+               pcounter pc(ip->pc);
+               execute_mvintconst(pc);
+            }
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_MOVE(MVWORLDFIELD_INSTR, mvworldfield, execute_mvworldfield)
+
+         DECODED_CASE(MVSTACKPCOUNTER_INSTR)
+            DECODED_COMPLEX_JUMP(mvstackpcounter)
+            COUNT_MOVE();
+            // return from a function call, skip the CALLF instruction
+            ip = (const decoded_instr*)FIELD_PTR(*(state.stack.get_stack_at(pcounter_stack(ip->pc + instr_size)))) + 1;
+            DECODED_JUMP_NEXT();
+         ENDOP()
+
+         DECODED_CASE(MVPCOUNTERSTACK_INSTR)
+            DECODED_JUMP(mvpcounterstack)
+            COUNT_MOVE();
+            SET_FIELD_PTR(*(state.stack.get_stack_at(pcounter_stack(ip->pc + instr_size))), nip);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_MOVE(MVSTACKREG_INSTR, mvstackreg, execute_mvstackreg)
+         DECODED_MOVE(MVREGSTACK_INSTR, mvregstack, execute_mvregstack)
+         DECODED_MOVE(MVADDRREG_INSTR, mvaddrreg, execute_mvaddrreg)
+
+         DECODED_CASE(MVHOSTREG_INSTR)
+            DECODED_JUMP(mvhostreg)
+            COUNT_MOVE();
+#ifdef USE_REAL_NODES
+            state.set_node(ip->reg1, (node_val)state.node);
+#else
+            state.set_node(ip->reg1, state.node->get_id());
+#endif
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_OPERATION(ADDRNOTEQUAL_INSTR, addrnotequal, set_bool, get_node, !=)
+         DECODED_OPERATION(ADDREQUAL_INSTR, addrequal, set_bool, get_node, ==)
+         DECODED_OPERATION(INTMINUS_INSTR, intminus, set_int, get_int, -)
+         DECODED_OPERATION(INTEQUAL_INSTR, intequal, set_int, get_int, ==)
+         DECODED_OPERATION(INTNOTEQUAL_INSTR, intnotequal, set_int, get_int, !=)
+         DECODED_OPERATION(INTPLUS_INSTR, intplus, set_int, get_int, +)
+         DECODED_OPERATION(INTLESSER_INSTR, intlesser, set_bool, get_int, <)
+         DECODED_OPERATION(INTGREATEREQUAL_INSTR, intgreaterequal, set_bool, get_int, >=)
+         DECODED_OPERATION(BOOLOR_INSTR, boolor, set_bool, get_bool, ||)
+         DECODED_OPERATION(INTLESSEREQUAL_INSTR, intlesserequal, set_bool, get_int, <=)
+         DECODED_OPERATION(INTGREATER_INSTR, intgreater, set_bool, get_int, >)
+         DECODED_OPERATION(INTMUL_INSTR, intmul, set_int, get_int, *)
+         DECODED_OPERATION(INTDIV_INSTR, intdiv, set_int, get_int, /)
+         DECODED_OPERATION(INTMOD_INSTR, intmod, set_int, get_int, %)
+         DECODED_OPERATION(FLOATPLUS_INSTR, floatplus, set_float, get_float, +)
+         DECODED_OPERATION(FLOATMINUS_INSTR, floatminus, set_float, get_float, -)
+         DECODED_OPERATION(FLOATMUL_INSTR, floatmul, set_float, get_float, *)
+         DECODED_OPERATION(FLOATDIV_INSTR, floatdiv, set_float, get_float, /)
+         DECODED_OPERATION(FLOATEQUAL_INSTR, floatequal, set_bool, get_float, ==)
+         DECODED_OPERATION(FLOATNOTEQUAL_INSTR, floatnotequal, set_bool, get_float, !=)
+         DECODED_OPERATION(FLOATLESSER_INSTR, floatlesser, set_bool, get_float, <)
+         DECODED_OPERATION(FLOATLESSEREQUAL_INSTR, floatlesserequal, set_bool, get_float, <=)
+         DECODED_OPERATION(FLOATGREATER_INSTR, floatgreater, set_bool, get_float, >)
+         DECODED_OPERATION(FLOATGREATEREQUAL_INSTR, floatgreaterequal, set_bool, get_float, >=)
+
+         DECODED_CASE(MVREGREG_INSTR)
+            DECODED_JUMP(mvregreg)
+            COUNT_MOVE();
+            state.copy_reg(ip->reg1, ip->reg2);
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_OPERATION(BOOLEQUAL_INSTR, boolequal, set_bool, get_bool, ==)
+         DECODED_OPERATION(BOOLNOTEQUAL_INSTR, boolnotequal, set_bool, get_bool, !=)
+
+         DECODED_BYTECODE(HEADRR_INSTR, headrr, execute_headrr)
+         DECODED_BYTECODE(HEADFR_INSTR, headfr, execute_headfr)
+         DECODED_BYTECODE(HEADFF_INSTR, headff, execute_headff)
+         DECODED_BYTECODE(HEADRF_INSTR, headrf, execute_headrf)
+         DECODED_BYTECODE(HEADFFR_INSTR, headffr, execute_headffr)
+         DECODED_BYTECODE(HEADRFR_INSTR, headrfr, execute_headrfr)
+         DECODED_BYTECODE(TAILRR_INSTR, tailrr, execute_tailrr)
+         DECODED_BYTECODE(TAILFR_INSTR, tailfr, execute_tailfr)
+         DECODED_BYTECODE(TAILFF_INSTR, tailff, execute_tailff)
+         DECODED_BYTECODE(TAILRF_INSTR, tailrf, execute_tailrf)
+
+         DECODED_MOVE(MVWORLDREG_INSTR, mvworldreg, execute_mvworldreg)
+         DECODED_MOVE(MVCONSTREG_INSTR, mvconstreg, execute_mvconstreg)
+         DECODED_MOVE(MVINTSTACK_INSTR, mvintstack, execute_mvintstack)
+         DECODED_MOVE(MVFLOATSTACK_INSTR, mvfloatstack, execute_mvfloatstack)
+         DECODED_MOVE(MVARGREG_INSTR, mvargreg, execute_mvargreg)
+
+         DECODED_BYTECODE(CONSRRR_INSTR, consrrr, execute_consrrr)
+         DECODED_BYTECODE(CONSRFF_INSTR, consrff, execute_consrff)
+         DECODED_BYTECODE(CONSFRF_INSTR, consfrf, execute_consfrf)
+         DECODED_BYTECODE(CONSFFR_INSTR, consffr, execute_consffr)
+         DECODED_BYTECODE(CONSRRF_INSTR, consrrf, execute_consrrf)
+         DECODED_BYTECODE(CONSRFR_INSTR, consrfr, execute_consrfr)
+         DECODED_BYTECODE(CONSFRR_INSTR, consfrr, execute_consfrr)
+         DECODED_BYTECODE(CONSFFF_INSTR, consfff, execute_consfff)
+
+         DECODED_BYTECODE(CALLE_INSTR, calle, execute_calle)
+         DECODED_BYTECODE(SET_PRIORITY_INSTR, set_priority, execute_set_priority)
+         DECODED_BYTECODE(SET_PRIORITYH_INSTR, set_priorityh, execute_set_priority_here)
+         DECODED_BYTECODE(ADD_PRIORITY_INSTR, add_priority, execute_add_priority)
+         DECODED_BYTECODE(ADD_PRIORITYH_INSTR, add_priorityh, execute_add_priority_here)
+
+         DECODED_CASE(STOP_PROG_INSTR)
+            DECODED_JUMP(stop_program)
+            sched::base::stop_flag = true;
+            DECODED_ADVANCE()
+         ENDOP()
+
+         DECODED_BYTECODE(CPU_ID_INSTR, cpu_id, execute_cpu_id)
+         DECODED_BYTECODE(NODE_PRIORITY_INSTR, node_priority, execute_node_priority)
+
+         // superinstructions
+         DECODED_CASE(FUSED_MVFIELDFIELD2_INSTR)
+            DECODED_COMPLEX_JUMP(fused_mvfieldfield2)
+            COUNT_MOVE();
+            COUNT_MOVE();
+            decoded_mvfieldfield(ip, state);
+            decoded_mvfieldfield(ip + 1, state);
+            ip += 2;
+            DECODED_JUMP_NEXT();
+         ENDOP()
+
+         DECODED_CASE(FUSED_MVFIELDREG2_INSTR)
+            DECODED_COMPLEX_JUMP(fused_mvfieldreg2)
+            COUNT_MOVE();
+            COUNT_MOVE();
+            decoded_mvfieldreg(ip, state);
+            decoded_mvfieldreg(ip + 1, state);
+            ip += 2;
+            DECODED_JUMP_NEXT();
+         ENDOP()
+
+         DECODED_CASE(FUSED_ALLOC_SEND_INSTR)
+            DECODED_COMPLEX_JUMP(fused_alloc_send)
+            {
+               execute_alloc(ip->pred, ip->reg1, state);
+
+               const decoded_instr *mv(ip + 1);
+               const decoded_instr *last(mv + ip->uint_value);
+
+               for(; mv != last; ++mv)
+                  execute_decoded_move(mv, state);
+
+               if(last->op == SEND_INSTR)
+                  execute_send(last->reg1, last->reg2, state);
+               else
+                  execute_add_linear(last->reg1, state);
+
+               ip = last + 1;
+               DECODED_JUMP_NEXT();
+            }
+         ENDOP()
+
+         DECODED_FUSED_TEST_IF(FUSED_INTLESSER_IF_INSTR, fused_intlesser_if, get_int, <)
+         DECODED_FUSED_TEST_IF(FUSED_INTLESSEREQUAL_IF_INSTR, fused_intlesserequal_if, get_int, <=)
+         DECODED_FUSED_TEST_IF(FUSED_INTGREATER_IF_INSTR, fused_intgreater_if, get_int, >)
+         DECODED_FUSED_TEST_IF(FUSED_INTGREATEREQUAL_IF_INSTR, fused_intgreaterequal_if, get_int, >=)
+         DECODED_FUSED_TEST_IF(FUSED_FLOATEQUAL_IF_INSTR, fused_floatequal_if, get_float, ==)
+         DECODED_FUSED_TEST_IF(FUSED_FLOATNOTEQUAL_IF_INSTR, fused_floatnotequal_if, get_float, !=)
+         DECODED_FUSED_TEST_IF(FUSED_FLOATLESSER_IF_INSTR, fused_floatlesser_if, get_float, <)
+         DECODED_FUSED_TEST_IF(FUSED_FLOATLESSEREQUAL_IF_INSTR, fused_floatlesserequal_if, get_float, <=)
+         DECODED_FUSED_TEST_IF(FUSED_FLOATGREATER_IF_INSTR, fused_floatgreater_if, get_float, >)
+         DECODED_FUSED_TEST_IF(FUSED_FLOATGREATEREQUAL_IF_INSTR, fused_floatgreaterequal_if, get_float, >=)
+         DECODED_FUSED_TEST_IF(FUSED_ADDREQUAL_IF_INSTR, fused_addrequal_if, get_node, ==)
+         DECODED_FUSED_TEST_IF(FUSED_ADDRNOTEQUAL_IF_INSTR, fused_addrnotequal_if, get_node, !=)
+
+         DECODED_COMPLEX_JUMP(not_found)
+#ifndef COMPUTED_GOTOS
+         default:
+#endif
+            throw vm_exec_error("unsupported instruction");
+         ENDOP()
+#ifndef COMPUTED_GOTOS
+      }
+   }
+#endif
+}
+
 static inline return_type
-do_execute(byte_code code, state& state, const reg_num reg, vm::tuple *tpl, predicate *pred)
+execute(const decoded_instr *ip, state& state, const reg_num reg, tuple *tpl, predicate *pred)
+{
+   return execute_decoded(ip, &state, reg, tpl, pred);
+}
+
+void*
+decoded_handler(const utils::byte op)
+{
+#ifdef COMPUTED_GOTOS
+   if(decoded_jump_table == NULL)
+      execute_decoded(NULL, NULL, 0, NULL, NULL);
+   if(op >= FUSED_FIRST_INSTR && op < FUSED_END_INSTR)
+      return decoded_fused_table[op - FUSED_FIRST_INSTR];
+   return decoded_jump_table[op];
+#else
+   (void)op;
+   return NULL;
+#endif
+}
+
+template <typename CODE>
+static inline return_type
+do_execute(const CODE code, state& state, const reg_num reg, vm::tuple *tpl, predicate *pred)
 {
    assert(state.stack.empty());
    assert(state.removed.empty());
@@ -3524,8 +4390,11 @@ do_execute(byte_code code, state& state, const reg_num reg, vm::tuple *tpl, pred
    state.linear_facts_generated = 0;
    state.persistent_facts_generated = 0;
    state.linear_facts_consumed = 0;
+#ifdef OPCODE_PROFILING
+   state.opcodes.start();
+#endif
 
-   const return_type ret(execute((pcounter)code, state, reg, tpl, pred));
+   const return_type ret(execute(code, state, reg, tpl, pred));
 
    state.cleanup();
    assert(state.removed.empty());
@@ -3537,7 +4406,14 @@ execution_return
 execute_process(byte_code code, state& state, vm::tuple *tpl, predicate *pred)
 {
    state.running_rule = false;
-   const return_type ret(do_execute(code, state, 0, tpl, pred));
+   return_type ret;
+
+   if(state::PREDECODED) {
+      const decoded_instr *first(pred ? theProgram->get_predicate_decoded(pred->get_id()) : theProgram->get_const_decoded());
+      assert(first->pc == code);
+      ret = do_execute(first, state, 0, tpl, pred);
+   } else
+      ret = do_execute((pcounter)code, state, 0, tpl, pred);
 	
 #ifdef CORE_STATISTICS
 #endif
@@ -3574,7 +4450,10 @@ execute_rule(const rule_id rule_id, state& state)
    else
 #endif
    {
-      do_execute(rule->get_bytecode(), state, 0, NULL, NULL);
+      if(state::PREDECODED)
+         do_execute(rule->get_decoded(), state, 0, NULL, NULL);
+      else
+         do_execute((pcounter)rule->get_bytecode(), state, 0, NULL, NULL);
    }
 
 #ifdef CORE_STATISTICS
@@ -8,20 +8,26 @@
 namespace vm
 {
 
+struct decoded_instr;
+
 class function
 {
    private:
 
       byte_code code;
 		code_size_t code_size;
+      const decoded_instr *decoded;
 
    public:
 
       byte_code get_bytecode(void) const { return code; }
       code_size_t get_bytecode_size(void) const { return code_size; }
 
+      void set_decoded(const decoded_instr *_decoded) { decoded = _decoded; }
+      const decoded_instr *get_decoded(void) const { return decoded; }
+
       explicit function(byte_code _code, code_size_t _size):
-         code(_code), code_size(_size)
+         code(_code), code_size(_size), decoded(NULL)
       {}
 
       ~function(void)
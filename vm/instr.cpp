@@ -909,6 +909,151 @@ instr_print(pcounter pc, const bool recurse, const int tabcount, const program *
    return advance(pc);
 }
 
+const char*
+instr_name(const instr_type op)
+{
+   switch(op) {
+      case RETURN_INSTR: return "RETURN";
+      case NEXT_INSTR: return "NEXT";
+      case PERS_ITER_INSTR: return "PERS_ITER";
+      case TESTNIL_INSTR: return "TESTNIL";
+      case OPERS_ITER_INSTR: return "OPERS_ITER";
+      case LINEAR_ITER_INSTR: return "LINEAR_ITER";
+      case RLINEAR_ITER_INSTR: return "RLINEAR_ITER";
+      case NOT_INSTR: return "NOT";
+      case SEND_INSTR: return "SEND";
+      case FLOAT_INSTR: return "FLOAT";
+      case SELECT_INSTR: return "SELECT";
+      case RETURN_SELECT_INSTR: return "RETURN_SELECT";
+      case OLINEAR_ITER_INSTR: return "OLINEAR_ITER";
+      case DELETE_INSTR: return "DELETE";
+      case RESET_LINEAR_INSTR: return "RESET_LINEAR";
+      case END_LINEAR_INSTR: return "END_LINEAR";
+      case RULE_INSTR: return "RULE";
+      case RULE_DONE_INSTR: return "RULE_DONE";
+      case ORLINEAR_ITER_INSTR: return "ORLINEAR_ITER";
+      case NEW_NODE_INSTR: return "NEW_NODE";
+      case NEW_AXIOMS_INSTR: return "NEW_AXIOMS";
+      case SEND_DELAY_INSTR: return "SEND_DELAY";
+      case PUSH_INSTR: return "PUSH";
+      case POP_INSTR: return "POP";
+      case PUSH_REGS_INSTR: return "PUSH_REGS";
+      case POP_REGS_INSTR: return "POP_REGS";
+      case CALLF_INSTR: return "CALLF";
+      case CALLE_INSTR: return "CALLE";
+      case SET_PRIORITY_INSTR: return "SET_PRIORITY";
+      case MAKE_STRUCTR_INSTR: return "MAKE_STRUCTR";
+      case MVINTFIELD_INSTR: return "MVINTFIELD";
+      case MVINTREG_INSTR: return "MVINTREG";
+      case CALL_INSTR: return "CALL";
+      case MVFIELDFIELD_INSTR: return "MVFIELDFIELD";
+      case MVFIELDREG_INSTR: return "MVFIELDREG";
+      case MVPTRREG_INSTR: return "MVPTRREG";
+      case MVNILREG_INSTR: return "MVNILREG";
+      case MVFIELDFIELDR_INSTR: return "MVFIELDFIELDR";
+      case MVREGFIELD_INSTR: return "MVREGFIELD";
+      case MVREGFIELDR_INSTR: return "MVREGFIELDR";
+      case MVHOSTFIELD_INSTR: return "MVHOSTFIELD";
+      case MVREGCONST_INSTR: return "MVREGCONST";
+      case MVCONSTFIELD_INSTR: return "MVCONSTFIELD";
+      case MVCONSTFIELDR_INSTR: return "MVCONSTFIELDR";
+      case MVADDRFIELD_INSTR: return "MVADDRFIELD";
+      case MVFLOATFIELD_INSTR: return "MVFLOATFIELD";
+      case MVFLOATREG_INSTR: return "MVFLOATREG";
+      case MVINTCONST_INSTR: return "MVINTCONST";
+      case SET_PRIORITYH_INSTR: return "SET_PRIORITYH";
+      case MVWORLDFIELD_INSTR: return "MVWORLDFIELD";
+      case MVSTACKPCOUNTER_INSTR: return "MVSTACKPCOUNTER";
+      case MVPCOUNTERSTACK_INSTR: return "MVPCOUNTERSTACK";
+      case MVSTACKREG_INSTR: return "MVSTACKREG";
+      case MVREGSTACK_INSTR: return "MVREGSTACK";
+      case MVADDRREG_INSTR: return "MVADDRREG";
+      case MVHOSTREG_INSTR: return "MVHOSTREG";
+      case ADDRNOTEQUAL_INSTR: return "ADDRNOTEQUAL";
+      case ADDREQUAL_INSTR: return "ADDREQUAL";
+      case INTMINUS_INSTR: return "INTMINUS";
+      case INTEQUAL_INSTR: return "INTEQUAL";
+      case INTNOTEQUAL_INSTR: return "INTNOTEQUAL";
+      case INTPLUS_INSTR: return "INTPLUS";
+      case INTLESSER_INSTR: return "INTLESSER";
+      case INTGREATEREQUAL_INSTR: return "INTGREATEREQUAL";
+      case ALLOC_INSTR: return "ALLOC";
+      case BOOLOR_INSTR: return "BOOLOR";
+      case INTLESSEREQUAL_INSTR: return "INTLESSEREQUAL";
+      case INTGREATER_INSTR: return "INTGREATER";
+      case INTMUL_INSTR: return "INTMUL";
+      case INTDIV_INSTR: return "INTDIV";
+      case FLOATPLUS_INSTR: return "FLOATPLUS";
+      case FLOATMINUS_INSTR: return "FLOATMINUS";
+      case FLOATMUL_INSTR: return "FLOATMUL";
+      case FLOATDIV_INSTR: return "FLOATDIV";
+      case FLOATEQUAL_INSTR: return "FLOATEQUAL";
+      case FLOATNOTEQUAL_INSTR: return "FLOATNOTEQUAL";
+      case FLOATLESSER_INSTR: return "FLOATLESSER";
+      case FLOATLESSEREQUAL_INSTR: return "FLOATLESSEREQUAL";
+      case FLOATGREATER_INSTR: return "FLOATGREATER";
+      case FLOATGREATEREQUAL_INSTR: return "FLOATGREATEREQUAL";
+      case MVREGREG_INSTR: return "MVREGREG";
+      case BOOLEQUAL_INSTR: return "BOOLEQUAL";
+      case BOOLNOTEQUAL_INSTR: return "BOOLNOTEQUAL";
+      case HEADRR_INSTR: return "HEADRR";
+      case HEADFR_INSTR: return "HEADFR";
+      case HEADFF_INSTR: return "HEADFF";
+      case HEADRF_INSTR: return "HEADRF";
+      case HEADFFR_INSTR: return "HEADFFR";
+      case HEADRFR_INSTR: return "HEADRFR";
+      case TAILRR_INSTR: return "TAILRR";
+      case TAILFR_INSTR: return "TAILFR";
+      case TAILFF_INSTR: return "TAILFF";
+      case TAILRF_INSTR: return "TAILRF";
+      case MVWORLDREG_INSTR: return "MVWORLDREG";
+      case MVCONSTREG_INSTR: return "MVCONSTREG";
+      case CONSRRR_INSTR: return "CONSRRR";
+      case IF_INSTR: return "IF";
+      case CONSRFF_INSTR: return "CONSRFF";
+      case CONSFRF_INSTR: return "CONSFRF";
+      case CONSFFR_INSTR: return "CONSFFR";
+      case CONSRRF_INSTR: return "CONSRRF";
+      case CONSRFR_INSTR: return "CONSRFR";
+      case CONSFRR_INSTR: return "CONSFRR";
+      case CONSFFF_INSTR: return "CONSFFF";
+      case CALL0_INSTR: return "CALL0";
+      case CALL1_INSTR: return "CALL1";
+      case CALL2_INSTR: return "CALL2";
+      case CALL3_INSTR: return "CALL3";
+      case MVINTSTACK_INSTR: return "MVINTSTACK";
+      case PUSHN_INSTR: return "PUSHN";
+      case MAKE_STRUCTF_INSTR: return "MAKE_STRUCTF";
+      case STRUCT_VALRR_INSTR: return "STRUCT_VALRR";
+      case MVNILFIELD_INSTR: return "MVNILFIELD";
+      case STRUCT_VALFR_INSTR: return "STRUCT_VALFR";
+      case STRUCT_VALRF_INSTR: return "STRUCT_VALRF";
+      case STRUCT_VALRFR_INSTR: return "STRUCT_VALRFR";
+      case STRUCT_VALFF_INSTR: return "STRUCT_VALFF";
+      case STRUCT_VALFFR_INSTR: return "STRUCT_VALFFR";
+      case MVFLOATSTACK_INSTR: return "MVFLOATSTACK";
+      case ADDLINEAR_INSTR: return "ADDLINEAR";
+      case ADDPERS_INSTR: return "ADDPERS";
+      case RUNACTION_INSTR: return "RUNACTION";
+      case ENQUEUE_LINEAR_INSTR: return "ENQUEUE_LINEAR";
+      case UPDATE_INSTR: return "UPDATE";
+      case MVARGREG_INSTR: return "MVARGREG";
+      case INTMOD_INSTR: return "INTMOD";
+      case CPU_ID_INSTR: return "CPU_ID";
+      case NODE_PRIORITY_INSTR: return "NODE_PRIORITY";
+      case REMOVE_INSTR: return "REMOVE";
+      case IF_ELSE_INSTR: return "IF_ELSE";
+      case JUMP_INSTR: return "JUMP";
+      case ADD_PRIORITY_INSTR: return "ADD_PRIORITY";
+      case ADD_PRIORITYH_INSTR: return "ADD_PRIORITYH";
+      case STOP_PROG_INSTR: return "STOP_PROG";
+      case RETURN_LINEAR_INSTR: return "RETURN_LINEAR";
+      case RETURN_DERIVED_INSTR: return "RETURN_DERIVED";
+   }
+
+   return "UNKNOWN";
+}
+
 pcounter
 instr_print_simple(pcounter pc, const int tabcount, const program *prog, ostream& cout)
 {
@@ -411,6 +411,8 @@ typedef pcounter iter_match;
 
 inline ptr_val iter_match_object(pcounter pc) { return pcounter_ptr(pc + instr_size); }
 inline void iter_match_object_set(pcounter pc, ptr_val v) { *(ptr_val*)(pc + instr_size) = v; }
+// the match object slot holds the number of the iterator (see program::number_iterators)
+inline size_t iter_match_id(pcounter pc) { return (size_t)pcounter_ptr(pc + instr_size); }
 inline predicate_id iter_predicate(pcounter pc) { return predicate_get(pc, instr_size + ptr_size); }
 inline reg_num iter_reg(pcounter pc) { return pcounter_reg(pc + instr_size + ptr_size + predicate_size); }
 inline bool iter_constant_match(const pcounter pc) { return pcounter_bool(pc + instr_size + ptr_size + predicate_size + reg_val_size); }
@@ -925,6 +927,7 @@ advance(const pcounter pc)
 
 /* byte code print functions */
 pcounter instr_print(pcounter, const bool, const int, const program *, std::ostream&);
+const char *instr_name(const instr::instr_type);
 pcounter instr_print_simple(pcounter, const int, const program *, std::ostream&);
 byte_code instrs_print(const byte_code, const code_size_t, const int, const program*, std::ostream&);
 
@@ -0,0 +1,105 @@
+#include <vector>
+#include <algorithm>
+
+#include "vm/latency.hpp"
+
+#ifdef NODE_LATENCY_STATISTICS
+
+#include "vm/all.hpp"
+#include "db/database.hpp"
+#include "sched/base.hpp"
+
+using namespace std;
+using namespace db;
+
+// nodes with the highest latency that are printed
+#define LATENCY_TOP_NODES 10
+
+namespace vm
+{
+
+void
+latency_histogram::merge(const latency_histogram& other)
+{
+   for(size_t i(0); i < LATENCY_BUCKETS; ++i)
+      buckets[i] += other.buckets[i];
+   total += other.total;
+   max = std::max(max, other.max);
+}
+
+uint64_t
+latency_histogram::percentile(const double fraction) const
+{
+   const size_t target((size_t)(fraction * total));
+   size_t seen(0);
+
+   for(size_t i(0); i < LATENCY_BUCKETS; ++i) {
+      seen += buckets[i];
+      if(seen > target)
+         return (uint64_t)1 << i;
+   }
+
+   return max / 1000;
+}
+
+void
+latency_histogram::print(ostream& out) const
+{
+   out << "Node runs: " << total << endl;
+   if(total == 0)
+      return;
+
+   out << "Latency p50: <" << percentile(0.5) << "us p99: <" << percentile(0.99)
+      << "us p99.9: <" << percentile(0.999) << "us max: " << max / 1000 << "us" << endl;
+
+   for(size_t i(0); i < LATENCY_BUCKETS; ++i) {
+      if(buckets[i] > 0)
+         out << "\t<" << ((uint64_t)1 << i) << "us\t" << buckets[i] << endl;
+   }
+}
+
+latency_histogram::latency_histogram(void):
+   total(0), max(0)
+{
+   for(size_t i(0); i < LATENCY_BUCKETS; ++i)
+      buckets[i] = 0;
+}
+
+static bool
+higher_max_latency(const node *a, const node *b)
+{
+   return a->latency_max > b->latency_max;
+}
+
+void
+print_latency_statistics(ostream& out)
+{
+   latency_histogram all;
+
+   for(size_t i(0); i < All->NUM_THREADS; ++i)
+      all.merge(All->ALL_THREADS[i]->get_latencies());
+
+   all.print(out);
+
+   vector<node*> nodes;
+   for(database::iterator it(All->DATABASE->nodes_begin()), end(All->DATABASE->nodes_end()); it != end; ++it) {
+      node *n(*it);
+      if(n->latency_runs > 0)
+         nodes.push_back(n);
+   }
+
+   const size_t top(min(nodes.size(), (size_t)LATENCY_TOP_NODES));
+   partial_sort(nodes.begin(), nodes.begin() + top, nodes.end(), higher_max_latency);
+
+   out << "Nodes with the highest latency:" << endl;
+   for(size_t i(0); i < top; ++i) {
+      const node *n(nodes[i]);
+      out << "\tnode " << n->get_id() << "\truns " << n->latency_runs
+         << "\tmean " << n->latency_total / n->latency_runs / 1000 << "us"
+         << "\tmax " << n->latency_max / 1000 << "us" << endl;
+   }
+}
+
+}
+
+#endif
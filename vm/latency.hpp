@@ -0,0 +1,56 @@
+
+#ifndef VM_LATENCY_HPP
+#define VM_LATENCY_HPP
+
+#include <ostream>
+#include <stdint.h>
+
+#include "conf.hpp"
+
+#ifdef NODE_LATENCY_STATISTICS
+namespace vm
+{
+
+// bucket i counts the latencies between 2^(i-1) and 2^i microseconds
+#define LATENCY_BUCKETS 32
+
+// distribution of the time nodes wait between getting new facts and running
+struct latency_histogram
+{
+   size_t buckets[LATENCY_BUCKETS];
+   size_t total;
+   uint64_t max;
+
+   inline void add(const uint64_t ns)
+   {
+      uint64_t us(ns / 1000);
+      size_t b(0);
+
+      while(us > 0 && b < LATENCY_BUCKETS - 1) {
+         us >>= 1;
+         ++b;
+      }
+
+      buckets[b]++;
+      total++;
+      if(ns > max)
+         max = ns;
+   }
+
+   void merge(const latency_histogram&);
+
+   // upper bound of the latency of the given fraction of the runs, in microseconds
+   uint64_t percentile(const double) const;
+
+   void print(std::ostream&) const;
+
+   explicit latency_histogram(void);
+};
+
+// latencies of all the threads and of the slowest nodes
+void print_latency_statistics(std::ostream&);
+
+}
+#endif
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "vm/predicate.hpp"
 #include "vm/state.hpp"
+#include "vm/tuple.hpp"
 
 using namespace std;
 using namespace vm;
@@ -176,23 +177,57 @@ predicate::make_predicate_from_reader(code_reader& read, code_size_t *code_size,
    return pred;
 }
 
+const field_layout *predicate::layouts[1 << (8 * sizeof(predicate_id))];
+
 void
 predicate::build_field_info(void)
 {
-   size_t offset = 0;
-   
-   fields_size.resize(num_fields());
-   fields_offset.resize(num_fields());
-   
+   fields_layout.resize(num_fields());
+
+#ifdef COMPACT_TUPLES
+   // bigger fields are placed first, each one at the first free position
+   // with the right alignment, small fields fill the header padding
+   vector<bool> used(TUPLE_FIELDS_START, true);
+
+   for(size_t size(sizeof(tuple_field)); size > 0; size /= 2) {
+      for(size_t i = 0; i < num_fields(); ++i) {
+         if(types[i]->size() != size)
+            continue;
+
+         size_t offset(TUPLE_FIELDS_START);
+
+         while(true) {
+            offset = (offset + size - 1) & ~(size - 1);
+
+            bool is_free(true);
+            for(size_t j(offset); j < offset + size && j < used.size(); ++j)
+               is_free = is_free && !used[j];
+            if(is_free)
+               break;
+            offset += size;
+         }
+
+         if(used.size() < offset + size)
+            used.resize(offset + size, false);
+         for(size_t j(offset); j < offset + size; ++j)
+            used[j] = true;
+
+         fields_layout[i].offset = offset;
+         fields_layout[i].size = size;
+      }
+   }
+
+   tuple_size = max(sizeof(tuple), (used.size() + sizeof(tuple_field) - 1) & ~(sizeof(tuple_field) - 1));
+#else
    for(size_t i = 0; i < num_fields(); ++i) {
-      const size_t size = types[i]->size();
-      
-      fields_size[i] = size;
-      fields_offset[i] = offset;
-      offset += size;
+      fields_layout[i].offset = sizeof(tuple) + i * sizeof(tuple_field);
+      fields_layout[i].size = types[i]->size();
    }
-   
-   tuple_size = offset;
+
+   tuple_size = sizeof(tuple) + num_fields() * sizeof(tuple_field);
+#endif
+
+   layouts[id] = num_fields() > 0 ? &fields_layout[0] : NULL;
 }
 
 void
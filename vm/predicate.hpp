@@ -24,9 +24,16 @@ const size_t PRED_AGG_INFO_MAX = 32;
 
 class program;
 
+// position and size of a field inside a tuple (see vm/tuple.hpp)
+typedef struct {
+   uint16_t offset;
+   uint16_t size;
+} field_layout;
+
 typedef enum {
    LINKED_LIST,
-   HASH_TABLE
+   HASH_TABLE,
+   COMPOSITE_HASH_TABLE
 } store_type_t;
 
 class predicate {
@@ -40,10 +47,12 @@ private:
    strat_level level;
    
    std::vector<type*> types;
-   std::vector<size_t> fields_size;
-   std::vector<size_t> fields_offset;
+   std::vector<field_layout> fields_layout;
    
-   size_t tuple_size;
+   size_t tuple_size; // bytes used by each tuple
+
+   // field layouts indexed by predicate id
+   static const field_layout *layouts[1 << (8 * sizeof(predicate_id))];
    
    typedef struct {
       field_num field;
@@ -74,6 +83,7 @@ private:
 
    store_type_t store_type;
    field_num hash_argument;
+   field_num hash_argument2;
 
    // Linked tuple list to store tuples on Blinky Block version of vm
    //#ifdef BLINKYBLOCKS
@@ -136,7 +146,10 @@ public:
    inline size_t num_fields(void) const { return types.size(); }
    
    inline type* get_field_type(const field_num field) const { return types[field]; }
-   inline size_t get_field_size(const field_num field) const { return fields_size[field]; }
+   inline size_t get_field_size(const field_num field) const { return fields_layout[field].size; }
+   inline size_t get_field_offset(const field_num field) const { return fields_layout[field].offset; }
+
+   static inline const field_layout *get_layout(const predicate_id id) { return layouts[id]; }
    
    inline std::string get_name(void) const { return name; }
    
@@ -149,15 +162,33 @@ public:
       hash_argument = field;
    }
 
+   // hash on both fields so that matches on the pair look at a single bucket
+   inline void store_as_hash_table(const field_num field1, const field_num field2) {
+      store_type = COMPOSITE_HASH_TABLE;
+      hash_argument = field1;
+      hash_argument2 = field2;
+   }
+
    inline field_num get_hashed_field(void) const
    {
       assert(is_hash_table());
       return hash_argument;
    }
 
+   inline field_num get_second_hashed_field(void) const
+   {
+      assert(has_composite_hash());
+      return hash_argument2;
+   }
+
    inline bool is_hash_table(void) const
    {
-      return store_type == HASH_TABLE;
+      return store_type != LINKED_LIST;
+   }
+
+   inline bool has_composite_hash(void) const
+   {
+      return store_type == COMPOSITE_HASH_TABLE;
    }
 
    inline void set_argument_position(const size_t arg)
@@ -13,6 +13,7 @@
 #include "vm/state.hpp"
 #include "vm/reader.hpp"
 #include "vm/external.hpp"
+#include "vm/decoded.hpp"
 #include "version.hpp"
 #ifdef USE_UI
 #include "ui/macros.hpp"
@@ -78,7 +79,8 @@ get_function_pointer(char *lib_path, char* func_name)
 
 program::program(const string& _filename):
    filename(_filename),
-   init(NULL)
+   init(NULL),
+   const_decoded(NULL)
 {
    code_reader read(filename);
 
@@ -237,6 +239,7 @@ program::program(const string& _filename):
 	const_code = new byte_code_el[const_code_size];
 	read.read_any(const_code, const_code_size);
    read_node_references(const_code, read);
+   number_iterators(const_code, const_code_size);
 
    MAX_STRAT_LEVEL = 0;
 
@@ -256,6 +259,7 @@ program::program(const string& _filename):
 
       functions[i] = new vm::function(fun_code, fun_size);
       read_node_references(fun_code, read);
+      number_iterators(fun_code, fun_size);
    }
 
    // get external functions definitions
@@ -351,8 +355,8 @@ program::program(const string& _filename):
          byte asc_desc;
 
          read.read_type<byte>(&type);
-         priority_type = FIELD_FLOAT;
-         assert(type == 0x01);
+         assert(type == FIELD_INT || type == FIELD_FLOAT);
+         priority_type = (field_type)type;
 
          read.read_type<byte>(&asc_desc);
          if(asc_desc & 0x01)
@@ -361,7 +365,10 @@ program::program(const string& _filename):
             priority_order = PRIORITY_DESC;
          priority_static = (asc_desc & 0x02) ? true : false;
 
-         read.read_type<float_val>(&initial_priority.float_priority);
+         if(priority_type == FIELD_INT)
+            read.read_type<int_val>(&initial_priority.int_priority);
+         else
+            read.read_type<float_val>(&initial_priority.float_priority);
       }
       break;
       case 0x03: { // data file
@@ -381,6 +388,7 @@ program::program(const string& _filename):
       
 		read.read_any(code[i], size);
       read_node_references(code[i], read);
+      number_iterators(code[i], size);
    }
 
    // read rules code
@@ -400,6 +408,7 @@ program::program(const string& _filename):
       rules[i]->set_bytecode(code_size, code);
 
       read_node_references(code, read);
+      number_iterators(code, code_size);
 
       byte is_persistent(0x0);
 
@@ -450,6 +459,9 @@ program::~program(void)
    for(size_t i(0); i < imported_predicates.size(); ++i) {
       delete imported_predicates[i];
    }
+   for(size_t i(0); i < decoded_blocks.size(); ++i) {
+      delete decoded_blocks[i];
+   }
    MAX_STRAT_LEVEL = 0;
 #ifdef USE_REAL_NODES
    delete []node_references;
@@ -474,6 +486,25 @@ program::read_node_references(byte_code code, code_reader& read)
 #endif
 }
 
+void
+program::number_iterators(byte_code code, const code_size_t size)
+{
+   for(pcounter pc(code); pc < code + size; pc = advance(pc)) {
+      switch(fetch(pc)) {
+         case PERS_ITER_INSTR:
+         case OPERS_ITER_INSTR:
+         case LINEAR_ITER_INSTR:
+         case RLINEAR_ITER_INSTR:
+         case OLINEAR_ITER_INSTR:
+         case ORLINEAR_ITER_INSTR:
+            iter_match_object_set(pc, (ptr_val)iter_matches.size());
+            iter_matches.push_back(null_ptr_val);
+            break;
+         default: break;
+      }
+   }
+}
+
 #ifdef USE_REAL_NODES
 void
 program::fix_node_addresses(db::database *data)
@@ -490,6 +521,34 @@ program::fix_node_addresses(db::database *data)
 }
 #endif
 
+const decoded_instr*
+program::add_decoded_code(byte_code code, const code_size_t size)
+{
+   decoded_code *block(new decoded_code(code, size, this));
+
+   decoded_blocks.push_back(block);
+
+   return block->get_first();
+}
+
+void
+program::decode_bytecode(void)
+{
+   assert(decoded_blocks.empty());
+
+   for(size_t i(0); i < functions.size(); ++i)
+      functions[i]->set_decoded(add_decoded_code(functions[i]->get_bytecode(), functions[i]->get_bytecode_size()));
+
+   const_decoded = add_decoded_code(const_code, const_code_size);
+
+   decoded.resize(num_predicates());
+   for(size_t i(0); i < num_predicates(); ++i)
+      decoded[i] = add_decoded_code(code[i], code_size[i]);
+
+   for(size_t i(0); i < number_rules; ++i)
+      rules[i]->set_decoded(add_decoded_code(rules[i]->get_bytecode(), rules[i]->get_codesize()));
+}
+
 predicate*
 program::get_predicate(const predicate_id& id) const
 {
@@ -34,6 +34,9 @@ namespace db {
 
 namespace vm {
 
+class decoded_code;
+struct decoded_instr;
+
 typedef enum {
    PRIORITY_ASC,
    PRIORITY_DESC
@@ -105,6 +108,20 @@ private:
 
    size_t total_arguments;
 
+   // pre-decoded code (see vm/decoded.hpp)
+   std::vector<decoded_code*> decoded_blocks;
+   std::vector<const decoded_instr*> decoded;
+   const decoded_instr *const_decoded;
+
+   const decoded_instr *add_decoded_code(byte_code, const code_size_t);
+
+   // match objects of the iterator instructions, indexed by iter_match_id.
+   // they are published with a compare-and-swap, which must not be done on
+   // the byte code since the slots in the instructions are not aligned
+   std::vector<ptr_val> iter_matches;
+
+   void number_iterators(byte_code, const code_size_t);
+
    void print_predicate_code(std::ostream&, predicate*) const;
    void read_node_references(byte_code, code_reader&);
    
@@ -169,6 +186,12 @@ public:
       return code[id];
    }
 	inline byte_code get_const_bytecode(void) const { return const_code; }
+
+   inline const decoded_instr *get_predicate_decoded(const predicate_id id) const {
+      assert(id < decoded.size());
+      return decoded[id];
+   }
+   inline const decoded_instr *get_const_decoded(void) const { return const_decoded; }
 	inline type* get_const_type(const const_id& id) const { return const_types[id]; }
    
    size_t num_predicates(void) const { return predicates.size(); }
@@ -188,6 +211,21 @@ public:
 #ifdef USE_REAL_NODES
    void fix_node_addresses(db::database*);
 #endif
+
+   // translate the byte code into pre-decoded code
+   void decode_bytecode(void);
+
+   inline ptr_val get_iter_match(const size_t id) const
+   {
+      assert(id < iter_matches.size());
+      return *(volatile const ptr_val*)&iter_matches[id];
+   }
+   // installs v only if no match object was set for the iterator yet
+   inline bool install_iter_match(const size_t id, const ptr_val v)
+   {
+      assert(id < iter_matches.size());
+      return __sync_bool_compare_and_swap(&iter_matches[id], null_ptr_val, v);
+   }
    
    explicit program(const std::string&);
    
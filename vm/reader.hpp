@@ -1,11 +1,15 @@
-
 #ifndef VM_READER_HPP
 #define VM_READER_HPP
 
 // reads byte code files
 
-#include <fstream>
 #include <string>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "vm/defs.hpp"
 #include "utils/types.hpp"
@@ -20,13 +24,23 @@ class load_file_error : public std::runtime_error {
     {}
 };
 
+// the whole file is mapped into memory so that reads are just copies
+// and big tables (such as the node table) can be used in place
 class code_reader
 {
    private:
 
-      std::ifstream fp;
+      const std::string file_name;
+      utils::byte *data;
+      size_t length;
       size_t position;
 
+      inline void check(const size_t size) const
+      {
+         if(position + size > length)
+            throw load_file_error(file_name, std::string("unexpected end of file"));
+      }
+
    public:
 
       template <typename T>
@@ -37,7 +51,8 @@ class code_reader
 
       inline void read(utils::byte *out, const size_t size)
       {
-         fp.read((char *)out, size);
+         check(size);
+         memcpy(out, data + position, size);
          position += size;
       }
 
@@ -49,15 +64,49 @@ class code_reader
 
       inline void seek(const size_t size)
       {
-         fp.seekg(size, std::ios_base::cur);
+         check(size);
+         position += size;
+      }
+
+      // returns a pointer to the next 'size' bytes and skips them
+      inline const utils::byte *read_in_place(const size_t size)
+      {
+         check(size);
+         const utils::byte *ret(data + position);
          position += size;
+         return ret;
       }
 
-      explicit code_reader(const std::string& file_name):
-            fp(file_name.c_str(), std::ios::in | std::ios::binary)
+      explicit code_reader(const std::string& _file_name):
+            file_name(_file_name), data(NULL), length(0), position(0)
       {
-         if(!fp.is_open())
+         const int fd(open(file_name.c_str(), O_RDONLY));
+         if(fd == -1)
             throw load_file_error(file_name, std::string("could not open file"));
+
+         struct stat st;
+         if(fstat(fd, &st) == -1) {
+            close(fd);
+            throw load_file_error(file_name, std::string("could not stat file"));
+         }
+
+         length = st.st_size;
+         if(length > 0) {
+            void *p(mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0));
+            if(p == MAP_FAILED) {
+               close(fd);
+               throw load_file_error(file_name, std::string("could not map file"));
+            }
+            data = (utils::byte*)p;
+            madvise(p, length, MADV_SEQUENTIAL);
+         }
+         close(fd);
+      }
+
+      ~code_reader(void)
+      {
+         if(data)
+            munmap(data, length);
       }
 };
 
@@ -14,6 +14,8 @@
 namespace vm
 {
 
+struct decoded_instr;
+
 class rule
 {
    private:
@@ -22,6 +24,7 @@ class rule
       const std::string str;
       byte_code code;
 		code_size_t code_size;
+      const decoded_instr *decoded;
 		typedef std::vector<predicate*> predicate_vector;
       predicate_vector predicates;
       bool is_persistent;
@@ -46,6 +49,9 @@ class rule
 		
       inline code_size_t get_codesize(void) const { return code_size; }
 		inline byte_code get_bytecode(void) const { return code; }
+
+      inline void set_decoded(const decoded_instr *_decoded) { decoded = _decoded; }
+      inline const decoded_instr *get_decoded(void) const { return decoded; }
 		inline size_t num_predicates(void) const { return predicates.size(); }
 
       inline void set_as_persistent(void) { is_persistent = true; }
@@ -56,7 +62,7 @@ class rule
 		inline predicate_iterator end_predicates(void) const { return predicates.end(); }
 
       explicit rule(const rule_id _id, const std::string& _str, const size_t predicates_next_uint):
-         id(_id), str(_str), is_persistent(false)
+         id(_id), str(_str), decoded(NULL), is_persistent(false)
       {
          bitmap::create(predicate_map, predicates_next_uint);
          predicate_map.clear(predicates_next_uint);
@@ -73,7 +73,10 @@ rule_matcher::register_tuple(predicate *pred, const derivation_count count, cons
 	}
 
    predicate_count[id] += count;
-   predicates.set_bit(id);
+   // only new tuples can produce new matches, repeated
+   // persistent tuples just increase the count of a known tuple
+   if(is_new)
+      predicates.set_bit(id);
 	return ret;
 }
 
@@ -106,8 +109,10 @@ rule_matcher::rule_matcher(void)
 
    bitmap::create(active_bitmap, theProgram->num_rules_next_uint());
    bitmap::create(dropped_bitmap, theProgram->num_rules_next_uint());
+   bitmap::create(pending_rules, theProgram->num_rules_next_uint());
    active_bitmap.clear(theProgram->num_rules_next_uint());
    dropped_bitmap.clear(theProgram->num_rules_next_uint());
+   pending_rules.clear(theProgram->num_rules_next_uint());
 
 #ifndef NDEBUG
    for(rule_id rid(0); rid < theProgram->num_rules(); ++rid)
@@ -127,6 +132,7 @@ rule_matcher::~rule_matcher(void)
    mem::allocator<utils::byte>().deallocate(rules, theProgram->num_rules());
    bitmap::destroy(active_bitmap, theProgram->num_rules_next_uint());
    bitmap::destroy(dropped_bitmap, theProgram->num_rules_next_uint());
+   bitmap::destroy(pending_rules, theProgram->num_rules_next_uint());
    bitmap::destroy(predicates, theProgram->num_predicates_next_uint());
 }
 
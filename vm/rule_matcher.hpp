@@ -25,9 +25,11 @@ public:
 
    bitmap active_bitmap; // rules that may run
    bitmap dropped_bitmap; // rules that are no longer runnable
-   bitmap predicates; // new generated predicates
+   bitmap predicates; // predicates with new tuples (the delta used to activate rules)
+   bitmap pending_rules; // rules left in the queue when the node ran out of its quota
 
-   // returns true if we did not have any tuples of this predicate
+   // returns true if we did not have any tuples of this predicate.
+   // tuples that are not new do not mark the predicate
 	bool register_tuple(predicate *, const derivation_count, const bool is_new = true);
 
 	// returns true if now we do not have any tuples of this predicate
@@ -1,5 +1,10 @@
 
+#include <fstream>
+#include <algorithm>
+
 #include "vm/stat.hpp"
+#include "vm/instr.hpp"
+#include "utils/spinlock.hpp"
 
 using namespace std;
 using namespace utils;
@@ -51,6 +56,9 @@ core_statistics::print(ostream& cout, vm::all *all) const
    	cout << "\tfailure rate: " << setprecision (2) << 100 * (float)stat_rules_failed / ((float)(stat_rules_ok + stat_rules_failed)) << "%" << endl;
    cout << "DB hits: " << stat_db_hits << endl;
    cout << "Tuples used: " << stat_tuples_used << endl;
+   cout << "Filtered searches: " << stat_filter_rejects + stat_filter_passed << endl;
+   	cout << "\trejected: " << stat_filter_rejects << endl;
+   	cout << "\tfalse positive rate: " << setprecision (2) << 100 * (float)stat_filter_false_positives / ((float)stat_filter_passed) << "%" << endl;
    cout << "If tests: " << stat_if_tests << endl;
    	cout << "\tfailed: " << stat_if_failed << endl;
    cout << "Instructions executed: " << stat_instructions_executed << endl;
@@ -108,6 +116,9 @@ core_statistics::core_statistics(vm::all *all)
    stat_rules_failed = 0;
    stat_db_hits = 0;
    stat_tuples_used = 0;
+   stat_filter_rejects = 0;
+   stat_filter_passed = 0;
+   stat_filter_false_positives = 0;
    stat_if_tests = 0;
    stat_if_failed = 0;
    stat_instructions_executed = 0;
@@ -131,3 +142,87 @@ core_statistics::core_statistics(vm::all *all)
 }
 
 #endif
+
+#ifdef OPCODE_PROFILING
+
+namespace vm
+{
+
+// profiles still alive and the counts of the ones already destroyed
+static utils::spinlock profiles_lock;
+static vector<opcode_profile*> profiles;
+static unordered_map<uint32_t, size_t> total_pairs;
+static unordered_map<uint32_t, size_t> total_triples;
+
+// number of sequences written for each length
+static const size_t PROFILE_TOP = 50;
+
+void
+opcode_profile::add_to(sequence_map& to_pairs, sequence_map& to_triples) const
+{
+   for(sequence_map::const_iterator it(pairs.begin()), end(pairs.end()); it != end; ++it)
+      to_pairs[it->first] += it->second;
+   for(sequence_map::const_iterator it(triples.begin()), end(triples.end()); it != end; ++it)
+      to_triples[it->first] += it->second;
+}
+
+static void
+print_sequences(ostream& out, const string& title, const unordered_map<uint32_t, size_t>& seqs, const size_t len)
+{
+   vector< pair<size_t, uint32_t> > vec;
+
+   for(unordered_map<uint32_t, size_t>::const_iterator it(seqs.begin()), end(seqs.end()); it != end; ++it)
+      vec.push_back(make_pair(it->second, it->first));
+   sort(vec.begin(), vec.end(), std::greater< pair<size_t, uint32_t> >());
+
+   out << title << ":" << endl;
+   for(size_t i(0); i < vec.size() && i < PROFILE_TOP; ++i) {
+      out << "\t" << vec[i].first;
+      for(size_t j(len); j > 0; --j)
+         out << " " << instr_name((instr::instr_type)((vec[i].second >> (8 * (j - 1))) & 0xFF));
+      out << endl;
+   }
+}
+
+void
+opcode_profile::dump(const string& program)
+{
+   profiles_lock.lock();
+
+   sequence_map all_pairs(total_pairs);
+   sequence_map all_triples(total_triples);
+
+   for(vector<opcode_profile*>::iterator it(profiles.begin()), end(profiles.end()); it != end; ++it)
+      (*it)->add_to(all_pairs, all_triples);
+
+   profiles_lock.unlock();
+
+   const string file(program + ".opcodes");
+   ofstream out(file.c_str());
+
+   print_sequences(out, "Opcode pairs", all_pairs, 2);
+   print_sequences(out, "Opcode triples", all_triples, 3);
+
+   cerr << "Opcode profile written to " << file << endl;
+}
+
+opcode_profile::opcode_profile(void)
+{
+   start();
+
+   profiles_lock.lock();
+   profiles.push_back(this);
+   profiles_lock.unlock();
+}
+
+opcode_profile::~opcode_profile(void)
+{
+   profiles_lock.lock();
+   add_to(total_pairs, total_triples);
+   profiles.erase(find(profiles.begin(), profiles.end(), this));
+   profiles_lock.unlock();
+}
+
+}
+
+#endif
@@ -26,6 +26,11 @@ class core_statistics {
       size_t stat_db_hits;
       size_t stat_tuples_used;
 
+      // persistent search filter counters
+      size_t stat_filter_rejects;
+      size_t stat_filter_passed;
+      size_t stat_filter_false_positives;
+
       // instructions counters
       size_t stat_if_tests;
       size_t stat_if_failed;
@@ -74,4 +79,51 @@ class core_statistics {
 }
 #endif
 
+#ifdef OPCODE_PROFILING
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "utils/types.hpp"
+
+namespace vm
+{
+
+// counts the adjacent opcode pairs and triples executed by a thread
+class opcode_profile {
+   private:
+
+      typedef std::unordered_map<uint32_t, size_t> sequence_map;
+
+      sequence_map pairs;
+      sequence_map triples;
+      int last, before_last;
+
+      void add_to(sequence_map&, sequence_map&) const;
+
+   public:
+
+      inline void start(void) { last = before_last = -1; }
+
+      inline void record(const utils::byte op)
+      {
+         if(last >= 0) {
+            pairs[((uint32_t)last << 8) | op]++;
+            if(before_last >= 0)
+               triples[((uint32_t)before_last << 16) | ((uint32_t)last << 8) | op]++;
+         }
+         before_last = last;
+         last = op;
+      }
+
+      // writes the profile of all threads into <program>.opcodes
+      static void dump(const std::string&);
+
+      explicit opcode_profile(void);
+      ~opcode_profile(void);
+};
+
+}
+#endif
+
 #endif
@@ -27,6 +27,9 @@ bool state::UI = false;
 #ifdef USE_SIM
 bool state::SIM = false;
 #endif
+bool state::PREDECODED = false;
+bool state::COMPACT = false;
+size_t state::QUOTA = 0;
 
 #ifdef DYNAMIC_INDEXING
 static volatile deterministic_timestamp indexing_epoch(0);
@@ -223,9 +226,35 @@ state::check_instruction_limit(void) const
 }
 #endif
 
+// the node ran out of its quota. the rules left in the queue are saved in
+// the node and queued again on its next run (see restore_pending_rules),
+// new facts are kept in incoming until then (see node::add_work_myself)
+void
+state::yield_node(void)
+{
+   store->matcher.pending_rules.set_bits(rule_queue, theProgram->num_rules_next_uint());
+   rule_queue.clear(theProgram->num_rules_next_uint());
+   node->yielded = true;
+}
+
+// queue the rules saved by yield_node that can still run
+void
+state::restore_pending_rules(void)
+{
+   if(store->matcher.pending_rules.empty(theProgram->num_rules_next_uint()))
+      return;
+
+   rule_queue.set_bits_of_and_result(store->matcher.pending_rules, store->matcher.active_bitmap,
+         theProgram->num_rules_next_uint());
+   store->matcher.pending_rules.clear(theProgram->num_rules_next_uint());
+}
+
 bool
 state::do_persistent_tuples(void)
 {
+   if(!store->local_persistent.empty())
+      process_local_persistent_tuples();
+
    while(!store->persistent_tuples.empty()) {
 #ifdef USE_SIM
       if(check_instruction_limit()) {
@@ -324,8 +353,8 @@ state::process_incoming_tuples(void)
          lstore->increment_database(theProgram->get_predicate(it->first), ls, store->matcher);
       }
    }
-   if(!store->incoming_persistent_tuples.empty())
-      store->persistent_tuples.splice(store->persistent_tuples.end(), store->incoming_persistent_tuples);
+   if(store->has_incoming_persistent())
+      store->move_incoming_persistent(store->persistent_tuples);
 }
 
 void
@@ -354,35 +383,56 @@ state::add_to_aggregate(db::simple_tuple *stpl)
 }
 
 void
-state::process_persistent_tuple(db::simple_tuple *stpl, vm::tuple *tpl)
+state::add_persistent_fact(vm::tuple *tpl, vm::predicate *pred, const derivation_count count, const depth_t depth)
 {
-   predicate *pred(stpl->get_predicate());
+   bool is_new;
 
-   // persistent tuples are marked inside this loop
-   if(stpl->get_count() > 0) {
-      bool is_new;
+   if(pred->is_reused_pred()) {
+      is_new = true;
+   } else {
+      is_new = add_fact_to_node(tpl, pred, count, depth);
+   }
 
-      if(pred->is_reused_pred()) {
-         is_new = true;
-      } else {
-         is_new = add_fact_to_node(tpl, pred, stpl->get_count(), stpl->get_depth());
-      }
+   if(is_new) {
+      setup(pred, node, count, depth);
+      execute_process(theProgram->get_predicate_bytecode(pred->get_id()), *this, tpl, pred);
+   }
+
+   if(pred->is_reused_pred()) {
+      node->add_linear_fact(tpl, pred);
+   } else {
+      store->matcher.register_tuple(pred, count, is_new);
 
-      if(is_new) {
-         setup(pred, node, stpl->get_count(), stpl->get_depth());
-         execute_process(theProgram->get_predicate_bytecode(pred->get_id()), *this, tpl, pred);
+      if(!is_new) {
+         vm::tuple::destroy(tpl, pred);
       }
+   }
+}
 
-      if(pred->is_reused_pred()) {
-         node->add_linear_fact(stpl->get_tuple(), pred);
-      } else {
-         store->matcher.register_tuple(pred, stpl->get_count(), is_new);
+// persistent tuples moved to the node by nodes of the same thread (see db::node::add_local_fact)
+void
+state::process_local_persistent_tuples(void)
+{
+   temporary_store::tuple_list ls;
 
-         if(!is_new) {
-            vm::tuple::destroy(tpl, pred);
-         }
-      }
+   ls.splice_back(store->local_persistent);
 
+   for(temporary_store::tuple_list::iterator it(ls.begin()), end(ls.end()); it != end; ) {
+      vm::tuple *tpl(*it);
+
+      ++it;
+      add_persistent_fact(tpl, theProgram->get_predicate(tpl->get_predicate_id()), 1, 0);
+   }
+}
+
+void
+state::process_persistent_tuple(db::simple_tuple *stpl, vm::tuple *tpl)
+{
+   predicate *pred(stpl->get_predicate());
+
+   // persistent tuples are marked inside this loop
+   if(stpl->get_count() > 0) {
+      add_persistent_fact(tpl, pred, stpl->get_count(), stpl->get_depth());
       delete stpl;
    } else {
 		if(pred->is_reused_pred()) {
@@ -422,6 +472,9 @@ state::process_persistent_tuple(db::simple_tuple *stpl, vm::tuple *tpl)
    }
 }
 
+// minimum share of matches and entropy wins (1/N) a second field needs to join the index
+#define COMPOSITE_INDEX_RATIO 2
+
 static vector< pair<predicate*, size_t> > one_indexing_fields;
 static vector< pair<predicate*, size_t> > two_indexing_fields;
 static vector<size_t> indexing_scores;
@@ -470,6 +523,52 @@ static unordered_map<vm::int_val, size_t> count_ints;
 static unordered_map<vm::float_val, size_t> count_floats;
 static unordered_map<vm::node_val, size_t> count_nodes;
 
+static inline size_t
+count_field_values(const db::intrusive_list<tuple> *ls, const predicate *pred, const size_t arg)
+{
+   size_t total(0);
+
+   for(db::intrusive_list<tuple>::iterator it(ls->begin()), end(ls->end()); it != end; ++it) {
+      vm::tuple *tpl(*it);
+      total++;
+      switch(pred->get_field_type(arg)->get_type()) {
+         case FIELD_INT: {
+            const int_val val(tpl->get_int(arg));
+            unordered_map<int_val, size_t>::iterator it(count_ints.find(val));
+            if(it == count_ints.end())
+               count_ints[val] = 1;
+            else
+               it->second++;
+         }
+         break;
+         case FIELD_FLOAT: {
+            const float_val val(tpl->get_float(arg));
+            unordered_map<float_val, size_t>::iterator it(count_floats.find(val));
+            if(it == count_floats.end())
+               count_floats[val] = 1;
+            else
+               it->second++;
+         }
+         break;
+         case FIELD_NODE: {
+            node_val val(tpl->get_node(arg));
+#ifdef USE_REAL_NODES
+            val = ((db::node*)val)->get_id();
+#endif
+            unordered_map<node_val, size_t>::iterator it(count_nodes.find(val));
+            if(it == count_nodes.end())
+               count_nodes[val] = 1;
+            else
+               it->second++;
+         }
+         break;
+         default: throw vm_exec_error("type not implemented"); assert(false); break;
+      }
+   }
+
+   return total;
+}
+
 static inline double
 compute_entropy(db::node *node, const predicate *pred, const size_t arg)
 {
@@ -481,48 +580,11 @@ compute_entropy(db::node *node, const predicate *pred, const size_t arg)
    assert(count_nodes.empty());
 
    if(node->linear.stored_as_hash_table(pred)) {
-      // XXX TODO
-   } else {
-      db::intrusive_list<tuple> *ls(node->linear.get_linked_list(pred->get_id()));
-
-      for(db::intrusive_list<tuple>::iterator it(ls->begin()), end(ls->end()); it != end; ++it) {
-         vm::tuple *tpl(*it);
-         total++;
-         switch(pred->get_field_type(arg)->get_type()) {
-            case FIELD_INT: {
-               const int_val val(tpl->get_int(arg));
-               unordered_map<int_val, size_t>::iterator it(count_ints.find(val));
-               if(it == count_ints.end())
-                  count_ints[val] = 1;
-               else
-                  it->second++;
-            }
-            break;
-            case FIELD_FLOAT: {
-               const float_val val(tpl->get_float(arg));
-               unordered_map<float_val, size_t>::iterator it(count_floats.find(val));
-               if(it == count_floats.end())
-                  count_floats[val] = 1;
-               else
-                  it->second++;
-            }
-            break;
-            case FIELD_NODE: {
-               node_val val(tpl->get_node(arg));
-#ifdef USE_REAL_NODES
-               val = ((db::node*)val)->get_id();
-#endif
-               unordered_map<node_val, size_t>::iterator it(count_nodes.find(val));
-               if(it == count_nodes.end())
-                  count_nodes[val] = 1;
-               else
-                  it->second++;
-            }
-            break;
-            default: throw vm_exec_error("type not implemented"); assert(false); break;
-         }
-      }
-   }
+      const db::hash_table *table(node->linear.get_hash_table(pred->get_id()));
+      for(db::hash_table::iterator it(table->begin()); !it.end(); ++it)
+         total += count_field_values(*it, pred, arg);
+   } else
+      total = count_field_values(node->linear.get_linked_list(pred->get_id()), pred, arg);
 
    double all((double)total);
    if(all <= 0.0)
@@ -559,6 +621,14 @@ compute_entropy(db::node *node, const predicate *pred, const size_t arg)
    return -ret;
 }
 
+// the second field is also indexed if it is matched and splits the facts
+// nearly as often as the best field
+static inline bool
+use_composite_index(const size_t count1, const size_t count2, const size_t score1, const size_t score2)
+{
+   return score2 > 0 && count2 * COMPOSITE_INDEX_RATIO >= count1 && score2 * COMPOSITE_INDEX_RATIO >= score1;
+}
+
 static inline void
 gather_indexing_stats_about_node(db::node *node, vm::counter *counter)
 {
@@ -642,7 +712,7 @@ state::indexing_state_machine(db::node *no)
 #endif
             if(pred->is_hash_table()) {
                const field_num old(pred->get_hashed_field());
-               if(old != arg) {
+               if(old != arg || pred->has_composite_hash()) {
                   different = true;
                   pred->store_as_hash_table(arg);
                }
@@ -676,9 +746,19 @@ state::indexing_state_machine(db::node *no)
             cout << arg1 << " " << match_counter->get_count(start + arg1) << " " << arg2 << " " << match_counter->get_count(start + arg2) << endl;
 #endif
             // arg1 is the best
-            if(pred->is_hash_table()) {
+            if(use_composite_index(match_counter->get_count(start + arg1), match_counter->get_count(start + arg2), score1, score2)) {
+#ifdef DEBUG_INDEXING
+               cout << "Composite index for " << pred->get_name() << " " << arg1 << " " << arg2 << endl;
+#endif
+               if(!pred->has_composite_hash() || pred->get_hashed_field() != arg1 ||
+                     pred->get_second_hashed_field() != arg2)
+               {
+                  different = true;
+                  pred->store_as_hash_table(arg1, arg2);
+               }
+            } else if(pred->is_hash_table()) {
                const field_num old(pred->get_hashed_field());
-               if(old != arg1) {
+               if(old != arg1 || pred->has_composite_hash()) {
                   different = true;
                   pred->store_as_hash_table(arg1);
                }
@@ -703,10 +783,17 @@ state::indexing_state_machine(db::node *no)
 #endif
 }
 
+// a node compacts its linear facts once every COMPACT_ROUNDS runs,
+// relocating about COMPACT_BUDGET tuples each time
+#define COMPACT_ROUNDS 16
+#define COMPACT_BUDGET 1024
+
 void
 state::run_node(db::node *no)
 {
    bool aborted(false);
+   size_t rules_run(0);
+   bool resuming(false);
 
    if(sched && sched->get_id() == 0)
       indexing_state_machine(no);
@@ -724,8 +811,21 @@ state::run_node(db::node *no)
 		execution_time::scope s(stat.core_engine_time);
 #endif
       no->lock();
+#ifdef NODE_LATENCY_STATISTICS
+      if(no->unprocessed_facts) {
+         const uint64_t latency(utils::get_nanoseconds() - no->pending_since);
+         latencies.add(latency);
+         no->latency_max = max(no->latency_max, latency);
+         no->latency_total += latency;
+         no->latency_runs++;
+      }
+#endif
       process_action_tuples();
-		process_incoming_tuples();
+      // a node that ran out of its quota first runs the rules it had queued
+      // and only then takes the new facts, as if it had not been interrupted
+      resuming = node->is_suspended();
+      if(!resuming)
+         process_incoming_tuples();
 #ifdef DYNAMIC_INDEXING
       if(node->indexing_epoch != indexing_epoch) {
          lstore->rebuild_index();
@@ -736,6 +836,8 @@ state::run_node(db::node *no)
       no->unlock();
 	}
 
+   no->yielded = false;
+
 #ifdef FASTER_INDEXING
    node->running = true;
    node->internal_lock();
@@ -746,6 +848,7 @@ state::run_node(db::node *no)
 #ifdef CORE_STATISTICS
 		execution_time::scope s(stat.core_engine_time);
 #endif
+      restore_pending_rules();
       mark_active_rules();
    } else
       // if using the simulator, we check if we exhausted the available time to run
@@ -756,6 +859,12 @@ state::run_node(db::node *no)
       if(check_instruction_limit())
          break;
 #endif
+      if(QUOTA > 0 && rules_run == QUOTA) {
+         yield_node();
+         break;
+      }
+      ++rules_run;
+
 		rule_id rule(rule_queue.remove_front(theProgram->num_rules_next_uint()));
 		
 #ifdef DEBUG_RULES
@@ -858,10 +967,23 @@ state::run_node(db::node *no)
    lstore->improve_index();
    if(node->rounds > 0 && node->rounds % 5 == 0)
       lstore->cleanup_index();
+   if(COMPACT && node->rounds % COMPACT_ROUNDS == 0)
+      lstore->compact(COMPACT_BUDGET);
 #ifdef FASTER_INDEXING
    node->internal_unlock();
    node->running = false;
 #endif
+
+   if(node->yielded || resuming) {
+      // run the node again later (for the facts left in incoming)
+      node->lock();
+      node->mark_unprocessed();
+      node->unlock();
+   }
+
+   // the owners of the objects freed by this node should not wait for
+   // the next nodes to fill the batches
+   mem::get_pool()->flush_remote_batches();
 }
 
 state::state(sched::base *_sched):
@@ -16,6 +16,7 @@
 #include "utils/time.hpp"
 #include "runtime/objs.hpp"
 #include "vm/stat.hpp"
+#include "vm/latency.hpp"
 #include "vm/call_stack.hpp"
 #include "vm/temporary.hpp"
 #include "db/linear_store.hpp"
@@ -91,9 +92,19 @@ public:
 #ifdef CORE_STATISTICS
    core_statistics stat;
 #endif
+#ifdef NODE_LATENCY_STATISTICS
+   latency_histogram latencies;
+#endif
+#ifdef OPCODE_PROFILING
+   opcode_profile opcodes;
+#endif
 #ifdef USE_UI
    static bool UI;
 #endif
+   static bool PREDECODED;
+   static bool COMPACT;
+   // rules a node may run before yielding to other nodes (0 for no limit)
+   static size_t QUOTA;
 #ifdef USE_SIM
    static bool SIM;
    deterministic_timestamp sim_instr_counter;
@@ -152,8 +163,12 @@ public:
 	bool add_fact_to_node(vm::tuple *, vm::predicate *, const vm::derivation_count count = 1, const vm::depth_t depth = 0);
 	
 	void mark_active_rules(void);
+   void yield_node(void);
+   void restore_pending_rules(void);
    void add_to_aggregate(db::simple_tuple *);
    bool do_persistent_tuples(void);
+   void add_persistent_fact(vm::tuple *, vm::predicate *, const vm::derivation_count, const vm::depth_t);
+   void process_local_persistent_tuples(void);
    void process_persistent_tuple(db::simple_tuple *, vm::tuple *);
 	void process_consumed_local_tuples(void);
 #ifdef USE_SIM
@@ -28,8 +28,9 @@ struct temporary_store
       // incoming linear tuples
       list_map incoming;
 
-      // incoming persistent tuples
-      db::simple_tuple_list incoming_persistent_tuples;
+      // incoming persistent tuples (a stack linked through next_incoming,
+      // pushed by any thread without holding the node lock)
+      db::simple_tuple * volatile incoming_persistent;
 
       // incoming action tuples
       db::simple_tuple_list incoming_action_tuples;
@@ -43,6 +44,10 @@ struct temporary_store
       // queue of persistent tuples
       db::simple_tuple_list persistent_tuples;
 
+      // persistent tuples moved here by the nodes of the owner thread, they
+      // are linked through the tuples and processed before persistent_tuples
+      tuple_list local_persistent;
+
       utils::spinlock spin;
       vm::rule_matcher matcher;
 
@@ -128,6 +133,44 @@ struct temporary_store
          persistent_tuples.push_back(stpl);
       }
 
+      // any thread
+      inline void add_incoming_persistent(db::simple_tuple *stpl)
+      {
+         while(true) {
+            db::simple_tuple *old(incoming_persistent);
+            stpl->next_incoming = old;
+            if(__sync_bool_compare_and_swap(&incoming_persistent, old, stpl))
+               return;
+         }
+      }
+
+      inline bool has_incoming_persistent(void) const { return incoming_persistent != NULL; }
+
+      // moves the incoming persistent tuples to 'ls' (in arrival order)
+      inline void move_incoming_persistent(db::simple_tuple_list& ls)
+      {
+         db::simple_tuple *stack((db::simple_tuple*)__sync_lock_test_and_set(&incoming_persistent, (db::simple_tuple*)NULL));
+         db::simple_tuple *reversed(NULL);
+
+         while(stack) {
+            db::simple_tuple *next(stack->next_incoming);
+            stack->next_incoming = reversed;
+            reversed = stack;
+            stack = next;
+         }
+
+         while(reversed) {
+            db::simple_tuple *next(reversed->next_incoming);
+            reversed->next_incoming = NULL;
+            ls.push_back(reversed);
+            reversed = next;
+         }
+      }
+
+      explicit temporary_store(void):
+         incoming_persistent(NULL)
+      {}
+
       ~temporary_store(void)
       {
          for(list_map::iterator it(incoming.begin()), end(incoming.end()); it != end; ++it) {
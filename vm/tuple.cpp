@@ -321,6 +321,7 @@ tuple::get_storage_size(predicate *pred) const
 
    for(size_t i(0); i < pred->num_fields(); ++i) {
       switch(pred->get_field_type(i)->get_type()) {
+         case FIELD_BOOL:
          case FIELD_INT:
          case FIELD_FLOAT:
          case FIELD_NODE:
@@ -348,6 +349,11 @@ tuple::pack(vm::predicate *pred, byte *buf, const size_t buf_size, int *pos) con
    
    for(field_num i(0); i < pred->num_fields(); ++i) {
       switch(pred->get_field_type(i)->get_type()) {
+         case FIELD_BOOL: {
+               const bool_val val(get_bool(i));
+               utils::pack<bool_val>((void*)&val, 1, buf, buf_size, pos);
+            }
+            break;
          case FIELD_INT: {
                const int_val val(get_int(i));
                utils::pack<int_val>((void*)&val, 1, buf, buf_size, pos);
@@ -378,6 +384,12 @@ tuple::load(vm::predicate *pred, byte *buf, const size_t buf_size, int *pos)
 {
    for(field_num i(0); i < pred->num_fields(); ++i) {
       switch(pred->get_field_type(i)->get_type()) {
+         case FIELD_BOOL: {
+               bool_val val;
+               utils::unpack<bool_val>(buf, buf_size, pos, &val, 1);
+               set_bool(i, val);
+            }
+            break;
          case FIELD_INT: {
                int_val val;
                utils::unpack<int_val>(buf, buf_size, pos, &val, 1);
@@ -24,6 +24,10 @@
 namespace vm
 {
 
+// fields start after the list pointers, the flags and the predicate id,
+// their position is given by the predicate (see predicate::build_field_info)
+const size_t TUPLE_FIELDS_START = 2 * sizeof(void*) + sizeof(utils::byte) + sizeof(predicate_id);
+
 struct tuple
 {
 public:
@@ -31,16 +35,29 @@ public:
 
 private:
    utils::byte flags;
+   predicate_id pred_id;
 
    void copy_field(type *, tuple *, const field_num) const;
 
+#ifdef COMPACT_TUPLES
+   inline const field_layout& layout(const field_num field) const { return predicate::get_layout(pred_id)[field]; }
+   inline utils::byte *fieldp(const field_num field) { return (utils::byte*)this + layout(field).offset; }
+   inline const utils::byte *fieldp(const field_num field) const { return (const utils::byte*)this + layout(field).offset; }
+#else
    inline tuple_field *getfp(void) { return (tuple_field*)(this + 1); }
    inline const tuple_field *getfp(void) const { return (tuple_field*)(this + 1); }
+   inline utils::byte *fieldp(const field_num field) { return (utils::byte*)(getfp() + field); }
+   inline const utils::byte *fieldp(const field_num field) const { return (const utils::byte*)(getfp() + field); }
+#endif
+
+#define FIELD_AT(TYPE, FIELD) (*(TYPE*)fieldp(FIELD))
 
 public:
 
    MEM_METHODS(tuple)
 
+   inline predicate_id get_predicate_id(void) const { return pred_id; }
+
    bool field_equal(type *, const tuple&, const field_num) const;
 
    bool equal(const tuple&, vm::predicate *) const;
@@ -48,17 +65,31 @@ public:
 #define define_set(NAME, TYPE, VAL) \
    inline void set_ ## NAME (const field_num& field, TYPE val) { VAL; }
 
-   define_set(bool, const bool_val&, SET_FIELD_BOOL(getfp()[field], val));
-   define_set(int, const int_val&, SET_FIELD_INT(getfp()[field], val));
-   define_set(float, const float_val&, SET_FIELD_FLOAT(getfp()[field], val));
-   define_set(ptr, const ptr_val&, SET_FIELD_PTR(getfp()[field], val));
-   define_set(node, const node_val&, SET_FIELD_NODE(getfp()[field], val));
-	define_set(string, const runtime::rstring::ptr, SET_FIELD_STRING(getfp()[field], val); val->inc_refs());
-   define_set(cons, runtime::cons*, SET_FIELD_CONS(getfp()[field], val); runtime::cons::inc_refs(val));
-   define_set(struct, runtime::struct1*, SET_FIELD_STRUCT(getfp()[field], val); val->inc_refs());
-
-   inline void set_nil(const field_num& field) { SET_FIELD_CONS(getfp()[field], runtime::cons::null_list()); }
+   define_set(bool, const bool_val&, FIELD_AT(bool_val, field) = val);
+   define_set(int, const int_val&, FIELD_AT(int_val, field) = val);
+   define_set(float, const float_val&, FIELD_AT(float_val, field) = val);
+   define_set(ptr, const ptr_val&, FIELD_AT(ptr_val, field) = val);
+   define_set(node, const node_val&, FIELD_AT(node_val, field) = val);
+	define_set(string, const runtime::rstring::ptr, FIELD_AT(ptr_val, field) = (ptr_val)val; val->inc_refs());
+   define_set(cons, runtime::cons*, FIELD_AT(ptr_val, field) = (ptr_val)val; runtime::cons::inc_refs(val));
+   define_set(struct, runtime::struct1*, FIELD_AT(ptr_val, field) = (ptr_val)val; val->inc_refs());
+
+   inline void set_nil(const field_num& field) { FIELD_AT(ptr_val, field) = (ptr_val)runtime::cons::null_list(); }
+#ifdef COMPACT_TUPLES
+   inline void set_field(const field_num& field, const tuple_field& f)
+   {
+      const field_layout& l(layout(field));
+      utils::byte *p((utils::byte*)this + l.offset);
+
+      switch(l.size) {
+         case sizeof(ptr_val): *(ptr_val*)p = FIELD_PTR(f); break;
+         case sizeof(int_val): *(int_val*)p = FIELD_INT(f); break;
+         default: *(bool_val*)p = FIELD_BOOL(f); break;
+      }
+   }
+#else
    inline void set_field(const field_num& field, const tuple_field& f) { getfp()[field] = f; }
+#endif
 #undef define_set
 
    size_t get_storage_size(vm::predicate *) const;
@@ -70,21 +101,40 @@ public:
    
    static tuple* unpack(utils::byte *, const size_t, int *, vm::program *);
 
+#ifdef COMPACT_TUPLES
+   // small fields are zero extended
+   inline tuple_field get_field(const field_num& field) const
+   {
+      const field_layout& l(layout(field));
+      const utils::byte *p((const utils::byte*)this + l.offset);
+      tuple_field ret;
+
+      switch(l.size) {
+         case sizeof(ptr_val): FIELD_PTR(ret) = *(ptr_val*)p; break;
+         case sizeof(int_val): FIELD_PTR(ret) = 0; FIELD_INT(ret) = *(int_val*)p; break;
+         default: FIELD_PTR(ret) = 0; FIELD_BOOL(ret) = *(bool_val*)p; break;
+      }
+
+      return ret;
+   }
+#else
    inline tuple_field get_field(const field_num& field) const { return getfp()[field]; }
+#endif
    
 #define define_get(RET, NAME, VAL) \
    inline RET get_ ## NAME (const field_num& field) const { return VAL; }
 
-   define_get(int_val, int, FIELD_INT(getfp()[field]));
-   define_get(float_val, float, FIELD_FLOAT(getfp()[field]));
-   define_get(ptr_val, ptr, FIELD_PTR(getfp()[field]));
-   define_get(bool_val, bool, FIELD_BOOL(getfp()[field]));
-   define_get(node_val, node, FIELD_NODE(getfp()[field]));
-	define_get(runtime::rstring::ptr, string, FIELD_STRING(getfp()[field]));
-   define_get(runtime::cons*, cons, FIELD_CONS(getfp()[field]));
-   define_get(runtime::struct1*, struct, FIELD_STRUCT(getfp()[field]));
+   define_get(int_val, int, FIELD_AT(int_val, field));
+   define_get(float_val, float, FIELD_AT(float_val, field));
+   define_get(ptr_val, ptr, FIELD_AT(ptr_val, field));
+   define_get(bool_val, bool, FIELD_AT(bool_val, field));
+   define_get(node_val, node, FIELD_AT(node_val, field));
+	define_get(runtime::rstring::ptr, string, (runtime::rstring::ptr)FIELD_AT(ptr_val, field));
+   define_get(runtime::cons*, cons, (runtime::cons*)FIELD_AT(ptr_val, field));
+   define_get(runtime::struct1*, struct, (runtime::struct1*)FIELD_AT(ptr_val, field));
 
 #undef define_get
+#undef FIELD_AT
 
    std::string to_str(const vm::predicate *) const;
    void print(std::ostream&, const vm::predicate*) const;
@@ -105,14 +155,23 @@ public:
    inline bool is_updated(void) const { return flags & TUPLE_UPDATED_FLAG; }
 
    inline static tuple* create(const predicate* pred) {
-      const size_t size(sizeof(vm::tuple) + sizeof(tuple_field) * pred->num_fields());
+      const size_t size(pred->get_size());
       vm::tuple *ptr((vm::tuple*)mem::center::allocate(size, 1));
       ptr->init(pred);
       return ptr;
    }
 
+   // moves the tuple to memory next to the previously relocated tuples
+   inline static tuple* relocate(tuple *tpl, const predicate *pred) {
+      const size_t size(pred->get_size());
+      vm::tuple *ptr((vm::tuple*)mem::center::allocate_contiguous(size, 1));
+      memcpy(ptr, tpl, size);
+      mem::allocator<utils::byte>().deallocate((utils::byte*)tpl, size);
+      return ptr;
+   }
+
    inline static void destroy(tuple *tpl, vm::predicate *pred) {
-      const size_t size(sizeof(vm::tuple) + sizeof(tuple_field) * pred->num_fields());
+      const size_t size(pred->get_size());
       tpl->destructor(pred);
       mem::allocator<utils::byte>().deallocate((utils::byte*)tpl, size);
    }
@@ -121,9 +180,10 @@ private:
 
    inline void init(const predicate *pred)
    {
-      flags = 0x00;
       assert(pred != NULL);
-      memset(getfp(), 0, sizeof(tuple_field) * pred->num_fields());
+      flags = 0x00;
+      pred_id = pred->get_id();
+      memset((utils::byte*)this + TUPLE_FIELDS_START, 0, pred->get_size() - TUPLE_FIELDS_START);
    }
 
    void destructor(vm::predicate*);